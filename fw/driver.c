@@ -13,114 +13,613 @@
  */
 
 #include "driver.h"
+#include "driver.pio.h"
+#include "global.h"
 #include "hw.h"
 
 #define SPI_CMD_READ_AT    0xC0
 #define SPI_CMD_READ_NEXT  0x80
 #define SPI_CMD_WRITE_AT   0x40
 #define SPI_CMD_WRITE_NEXT 0x00
+#define SPI_CMD_SET_ADDR   0x40
+#define SPI_CMD_BURST      0x20
+#define SPI_CMD_COUNT      0x10
+#define SPI_CMD_AND_AT     0xC2
+#define SPI_CMD_OR_AT      0xC4
+#define SPI_CMD_XOR_AT     0xC6
 
-void driver_init() {
-    // Configure SPI_CS_N_PIN as GPIO_OUT rather than GPIO_FUNC_SPI because the RP2040's
-    // hardware CS_N deasserts between bytes and our design relies on CS_N being held low
-    // to frame multibyte commands transmitted to the FPGA.
-    //
-    // (See https://github.com/raspberrypi/pico-sdk/issues/88)
+// Maximum payload of a single counted burst command.  Longer segments are split into
+// multiple commands, which continue at the next address without resending it.
+#define SPI_MAX_COUNT 256
+
+// Maximum commands per CS_N frame.  Transfers that require more commands continue in
+// a subsequent frame.
+#define SPI_MAX_FRAME_CMDS 32
+
+// pio0 is used by PicoDVI.
+#define FPGA_SPI_PIO pio1
+
+// DMA_IRQ_0 is used by PicoDVI on core 1.  DMA_IRQ_1 is shared with the SD card driver.
+#define FPGA_SPI_DMA_IRQ DMA_IRQ_1
+
+// DMA control block.  Matches the layout of the DMA channel's alias 1 registers
+// (CTRL, READ_ADDR, WRITE_ADDR, TRANS_COUNT_TRIG).  A block with a zero transfer count
+// is a null trigger, which terminates the chain and raises the channel's IRQ.
+typedef struct {
+    uint32_t ctrl;
+    const volatile void* read_addr;
+    volatile void* write_addr;
+    uint32_t transfer_count;
+} dma_cb;
+
+// TX words that begin a command (see driver.pio).
+typedef struct {
+    uint32_t control;               // Header bits - 1 (31:24), payload bytes (23:0)
+    uint32_t header;                // Command and argument bytes, left-justified
+} link_cmd;
+
+// All transfers (blocking and asynchronous) are queued and executed by the 'fpga_spi' PIO
+// program (see driver.pio), which handles CS_N framing and waits for READY_B.
+//
+// Each transfer is executed as a frame of commands.  A pair of DMA channels walks a list of
+// control blocks in each direction, gathering command and payload bytes into the PIO and
+// scattering received bytes into their destinations, so the CPU is only involved once per
+// frame.
+static struct {
+    spi_xfer* pHead;                // Next queued transfer
+    spi_xfer* pTail;                // Last queued transfer
+    spi_xfer* volatile pActive;     // Transfer in progress
+    uint32_t segIndex;              // Next segment of active transfer to execute
+    uint32_t segOffset;             // Offset within next segment
+    uint32_t frameStartUs;
+    uint lastCmd;                   // Index of last command in frame
+    uint lastStatusShift;           // Position of status byte in last command's RX header word
+    volatile uint8_t status;        // Most recent status byte received (see 'spi_status')
+
+    uint sm;
+    uint tx_data_channel;           // Command and payload -> PIO TX FIFO
+    uint tx_ctrl_channel;           // 'tx_cbs' -> 'tx_data_channel'
+    uint rx_data_channel;           // PIO RX FIFO -> headers and payload
+    uint rx_ctrl_channel;           // 'rx_cbs' -> 'rx_data_channel'
+
+    link_cmd cmds[SPI_MAX_FRAME_CMDS];
+    uint32_t rx_headers[SPI_MAX_FRAME_CMDS];
+    dma_cb tx_cbs[SPI_MAX_FRAME_CMDS * 2 + 2];
+    dma_cb rx_cbs[SPI_MAX_FRAME_CMDS * 2 + 1];
+
+    uint32_t tx_ctrl8;              // CTRL_TRIG values for 'tx_data_channel' (8-bit reads, incrementing or not)
+    uint32_t tx_ctrl8_incr;
+    uint32_t tx_ctrl32_incr;
+    uint32_t rx_ctrl8;              // CTRL_TRIG values for 'rx_data_channel'
+    uint32_t rx_ctrl8_incr;
+    uint32_t rx_ctrl32;
+
+    uint8_t tx_zero;                // Transmitted while receiving a burst read
+    uint8_t rx_discard;             // Received while transmitting a burst write
 
+    spi_link_stats stats;
+} link;
+
+// Terminates a frame (see driver.pio).
+static const uint32_t link_frame_end = 0;
+
+static void link_dma_irq_handler();
+
+static uint32_t link_data_ctrl(uint channel, uint ctrl_channel, enum dma_channel_transfer_size size, bool is_tx, bool incr) {
+    dma_channel_config config = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&config, size);
+    channel_config_set_dreq(&config, pio_get_dreq(FPGA_SPI_PIO, link.sm, is_tx));
+    channel_config_set_read_increment(&config, is_tx && incr);
+    channel_config_set_write_increment(&config, !is_tx && incr);
+    channel_config_set_chain_to(&config, ctrl_channel);
+
+    // Raise the IRQ when the null control block is reached rather than after each block.
+    channel_config_set_irq_quiet(&config, true);
+
+    return channel_config_get_ctrl_value(&config);
+}
+
+static void link_init_ctrl_channel(uint ctrl_channel, uint data_channel) {
+    // Each trigger copies one control block to the data channel's alias 1 registers.  The
+    // write address wraps after 4 words, and the last write (TRANS_COUNT_TRIG) starts the
+    // data channel.
+    dma_channel_config config = dma_channel_get_default_config(ctrl_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_ring(&config, /* write: */ true, /* size_bits: */ 4);
+    dma_channel_configure(ctrl_channel, &config,
+        /* write_addr: */ &dma_hw->ch[data_channel].al1_ctrl,
+        /* read_addr: */ NULL,
+        /* transfer_count: */ sizeof(dma_cb) / sizeof(uint32_t),
+        /* trigger: */ false);
+}
+
+void driver_init() {
+    // Hold CS_N high to reset the FPGA's state machine in case the MCU is reset mid-transmission,
+    // so it is ready for a new command.
     gpio_init(SPI_CSN_PIN);
     gpio_set_dir(SPI_CSN_PIN, GPIO_OUT);
     gpio_put(SPI_CSN_PIN, 1);
-
-    // In case the MCU is reset mid-transmission, Hold CS_N high long enough to trigger a
-    // synchronous reset of the FPGA's state machine so it is ready for a new command.
     sleep_ms(1);
     
     gpio_init(SPI_READY_B_PIN);
     gpio_set_dir(SPI_READY_B_PIN, GPIO_IN);
 
-    uint baudrate = spi_init(SPI_INSTANCE, SPI_MHZ * 1000 * 1000);
-    gpio_set_function(SPI_SCK_PIN, GPIO_FUNC_SPI);
-    gpio_set_function(SPI_TX_PIN, GPIO_FUNC_SPI);
-    gpio_set_function(SPI_RX_PIN, GPIO_FUNC_SPI);
+    // The SD card shares SCK, MOSI and MISO with the FPGA.  The PIO link owns these pins from
+    // here on, so the SD card is unusable while the link is active (see sd.h).
+
+    // Round the clock divider up to an integer so that SCK does not exceed SPI_MHZ and has
+    // no fractional divider jitter (e.g., 270 MHz / (3 * 4) = 22.5 MHz).
+    const uint32_t pio_hz = SPI_MHZ * 1000 * 1000 * FPGA_SPI_CYCLES_PER_BIT;
+    const uint clkdiv = (clock_get_hz(clk_sys) + pio_hz - 1) / pio_hz;
+    const uint offset = pio_add_program(FPGA_SPI_PIO, &fpga_spi_program);
+    link.sm = pio_claim_unused_sm(FPGA_SPI_PIO, /* required: */ true);
+    fpga_spi_program_init(FPGA_SPI_PIO, link.sm, offset, clkdiv,
+        SPI_TX_PIN, SPI_RX_PIN, SPI_CSN_PIN, SPI_READY_B_PIN);
+
+    link.tx_data_channel = dma_claim_unused_channel(/* required: */ true);
+    link.tx_ctrl_channel = dma_claim_unused_channel(/* required: */ true);
+    link.rx_data_channel = dma_claim_unused_channel(/* required: */ true);
+    link.rx_ctrl_channel = dma_claim_unused_channel(/* required: */ true);
+
+    link.tx_ctrl8       = link_data_ctrl(link.tx_data_channel, link.tx_ctrl_channel, DMA_SIZE_8,  /* is_tx: */ true, /* incr: */ false);
+    link.tx_ctrl8_incr  = link_data_ctrl(link.tx_data_channel, link.tx_ctrl_channel, DMA_SIZE_8,  /* is_tx: */ true, /* incr: */ true);
+    link.tx_ctrl32_incr = link_data_ctrl(link.tx_data_channel, link.tx_ctrl_channel, DMA_SIZE_32, /* is_tx: */ true, /* incr: */ true);
+    link.rx_ctrl8       = link_data_ctrl(link.rx_data_channel, link.rx_ctrl_channel, DMA_SIZE_8,  /* is_tx: */ false, /* incr: */ false);
+    link.rx_ctrl8_incr  = link_data_ctrl(link.rx_data_channel, link.rx_ctrl_channel, DMA_SIZE_8,  /* is_tx: */ false, /* incr: */ true);
+    link.rx_ctrl32      = link_data_ctrl(link.rx_data_channel, link.rx_ctrl_channel, DMA_SIZE_32, /* is_tx: */ false, /* incr: */ false);
+
+    link_init_ctrl_channel(link.tx_ctrl_channel, link.tx_data_channel);
+    link_init_ctrl_channel(link.rx_ctrl_channel, link.rx_data_channel);
 
-    printf("    spi1     = %d Bd\n", baudrate);
+    // The RX chain completes last, after the final byte of the frame has been received.
+    dma_channel_set_irq1_enabled(link.rx_data_channel, true);
+    irq_add_shared_handler(FPGA_SPI_DMA_IRQ, link_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(FPGA_SPI_DMA_IRQ, true);
+
+    printf("    fpga_spi = %d Bd\n", clock_get_hz(clk_sys) / (clkdiv * FPGA_SPI_CYCLES_PER_BIT));
 }
 
-void cmd_start() {
-    while (!gpio_get(SPI_READY_B_PIN));
-    gpio_put(SPI_CSN_PIN, 0);
+static void cb_set(dma_cb* pCb, const volatile void* read_addr, volatile void* write_addr, uint32_t transfer_count, uint32_t ctrl) {
+    pCb->ctrl           = ctrl;
+    pCb->read_addr      = read_addr;
+    pCb->write_addr     = write_addr;
+    pCb->transfer_count = transfer_count;
 }
 
-void cmd_end() {
-    while (gpio_get(SPI_READY_B_PIN));
-    gpio_put(SPI_CSN_PIN, 1);
+// Appends a command to the frame being built.  'pData' may be NULL if 'byteLength' is zero.
+static uint link_append_cmd(uint n, dma_cb** ppTx, dma_cb** ppRx, uint32_t header, uint headerLength, bool rw_n, uint8_t* pData, uint32_t byteLength) {
+    link.cmds[n].control = (headerLength * 8u - 1u) << 24 | byteLength;
+    link.cmds[n].header  = header;
+
+    // The FPGA returns its status byte during the command byte (the first header byte).
+    link.lastCmd = n;
+    link.lastStatusShift = (headerLength - 1u) * 8u;
+
+    const volatile void* txf = &FPGA_SPI_PIO->txf[link.sm];
+    volatile void* rxf = &FPGA_SPI_PIO->rxf[link.sm];
+
+    cb_set((*ppTx)++, &link.cmds[n], txf, 2, link.tx_ctrl32_incr);
+    cb_set((*ppRx)++, rxf, &link.rx_headers[n], 1, link.rx_ctrl32);
+
+    if (byteLength != 0) {
+        if (rw_n) {
+            cb_set((*ppTx)++, &link.tx_zero, txf, byteLength, link.tx_ctrl8);
+            cb_set((*ppRx)++, rxf, pData, byteLength, link.rx_ctrl8_incr);
+        } else {
+            cb_set((*ppTx)++, pData, txf, byteLength, link.tx_ctrl8_incr);
+            cb_set((*ppRx)++, rxf, &link.rx_discard, byteLength, link.rx_ctrl8);
+        }
+    }
+
+    link.stats.commands++;
+    link.stats.overheadBytes += headerLength;
+    link.stats.payloadBytes  += byteLength;
+
+    return n + 1;
 }
 
-uint8_t spi_read_at(uint32_t addr) {
-    const uint8_t cmd = SPI_CMD_READ_AT | addr >> 16;
-    const uint8_t addr_hi = addr >> 8;
-    const uint8_t addr_lo = addr & 0xff;
-    const uint8_t tx[] = { cmd, addr_hi, addr_lo };
+// Builds and starts the next frame of the active transfer.  Returns false if the transfer
+// has no remaining commands.
+static bool link_start_frame(spi_xfer* pXfer) {
+    dma_cb* pTx = link.tx_cbs;
+    dma_cb* pRx = link.rx_cbs;
+    uint n = 0;
+
+    if (pXfer->headerLength != 0) {
+        // Single non-burst command (e.g., READ_NEXT).  'segment' holds the bytes to read, if any.
+        if (link.segIndex == 0) {
+            n = link_append_cmd(n, &pTx, &pRx, pXfer->header, pXfer->headerLength, /* rw_n: */ true, pXfer->segment.pData, pXfer->segment.byteLength);
+            link.segIndex = 1;
+        }
+    } else {
+        while (n < SPI_MAX_FRAME_CMDS && link.segIndex < pXfer->numSegments) {
+            const spi_segment* const pSeg = &pXfer->pSegments[link.segIndex];
+            const uint32_t offset = link.segOffset;
+            const uint32_t remaining = pSeg->byteLength - offset;
+            const uint32_t count = MIN(remaining, SPI_MAX_COUNT);
 
-    cmd_start();
-    spi_write_blocking(SPI_INSTANCE, tx, sizeof(tx));
-    cmd_end();
+            if (count != 0) {
+                const uint32_t addr = pSeg->addr + offset;
+                const uint8_t cmd = (pSeg->rw_n ? SPI_CMD_READ_AT : SPI_CMD_WRITE_AT) | SPI_CMD_BURST | SPI_CMD_COUNT;
+                const uint8_t len = count & 0xff;     // 0 = 256
+
+                if (offset == 0 || n == 0) {
+                    // Set the address at the start of each segment and each frame.
+                    const uint8_t addr_hi = addr >> 8;
+                    const uint8_t addr_lo = addr & 0xff;
+                    n = link_append_cmd(n, &pTx, &pRx, (uint32_t) (cmd | addr >> 16) << 24 | addr_hi << 16 | addr_lo << 8 | len, 4, pSeg->rw_n, pSeg->pData + offset, count);
+                } else {
+                    // Continue at the next address.
+                    n = link_append_cmd(n, &pTx, &pRx, (uint32_t) (cmd & ~SPI_CMD_SET_ADDR) << 24 | len << 16, 2, pSeg->rw_n, pSeg->pData + offset, count);
+                }
+            }
+
+            if (count == remaining) {
+                link.segIndex++;
+                link.segOffset = 0;
+            } else {
+                link.segOffset += count;
+            }
+        }
+    }
+
+    if (n == 0) {
+        return false;
+    }
+
+    cb_set(pTx++, &link_frame_end, &FPGA_SPI_PIO->txf[link.sm], 1, link.tx_ctrl32_incr);
+    cb_set(pTx, NULL, NULL, 0, link.tx_ctrl32_incr);
+    cb_set(pRx, NULL, NULL, 0, link.rx_ctrl32);
+
+    link.stats.frames++;
+    link.frameStartUs = time_us_32();
+
+    // Start RX first so that it is ready to drain the PIO RX FIFO.
+    dma_channel_set_read_addr(link.rx_ctrl_channel, link.rx_cbs, /* trigger: */ true);
+    dma_channel_set_read_addr(link.tx_ctrl_channel, link.tx_cbs, /* trigger: */ true);
+
+    return true;
 }
 
-uint8_t spi_read_next() {
-    const uint8_t tx[1] = { SPI_CMD_READ_NEXT };
-    uint8_t rx[sizeof(tx)];
+// Begins the next queued transfer, if any.  Must be called with interrupts disabled or from
+// the driver's interrupt handler.
+static void link_start_next() {
+    while (true) {
+        spi_xfer* const pXfer = link.pHead;
+        link.pActive = pXfer;
 
-    cmd_start();
-    spi_write_read_blocking(SPI_INSTANCE, tx, rx, sizeof(tx));
-    cmd_end();
-    
-    return rx[0];
+        if (pXfer == NULL) {
+            return;
+        }
+
+        link.pHead = pXfer->pNext;
+        if (link.pHead == NULL) {
+            link.pTail = NULL;
+        }
+
+        link.segIndex  = 0;
+        link.segOffset = 0;
+
+        if (link_start_frame(pXfer)) {
+            return;
+        }
+
+        // Nothing to transfer (e.g., all segments are empty).
+        pXfer->done = true;
+        if (pXfer->pCallback != NULL) {
+            pXfer->pCallback(pXfer);
+        }
+    }
 }
 
-void spi_read(uint8_t* pDest, uint32_t src, uint32_t byteLength) {
-    spi_read_at(src);
+static void link_dma_irq_handler() {
+    if (!dma_channel_get_irq1_status(link.rx_data_channel)) {
+        // Interrupt is for another channel (e.g., SD card driver).
+        return;
+    }
+
+    dma_channel_acknowledge_irq1(link.rx_data_channel);
+
+    // All bytes of the frame have been received.  The PIO holds CS_N low until the FPGA asserts
+    // READY_B, so the next frame may be posted immediately.  The TX chain finishes pushing the
+    // end of frame marker at most a few cycles after the last byte is received.
+    link.stats.busyUs += time_us_32() - link.frameStartUs;
+    while (dma_channel_is_busy(link.tx_ctrl_channel) || dma_channel_is_busy(link.tx_data_channel)) {
+        tight_loop_contents();
+    }
+
+    link.status = link.rx_headers[link.lastCmd] >> link.lastStatusShift;
+
+    spi_xfer* const pXfer = link.pActive;
+    if (link_start_frame(pXfer)) {
+        // More segments remain.
+        return;
+    }
+
+    pXfer->done = true;
+    if (pXfer->pCallback != NULL) {
+        pXfer->pCallback(pXfer);
+    }
+
+    link_start_next();
+}
+
+static void link_enqueue(spi_xfer* pXfer) {
+    pXfer->done  = false;
+    pXfer->pNext = NULL;
+
+    const uint32_t status = save_and_disable_interrupts();
 
-    while (byteLength--) {
-        *pDest++ = spi_read_next();
+    if (link.pTail != NULL) {
+        link.pTail->pNext = pXfer;
+    } else {
+        link.pHead = pXfer;
     }
+
+    link.pTail = pXfer;
+
+    if (link.pActive == NULL) {
+        link_start_next();
+    }
+
+    restore_interrupts(status);
+}
+
+static void xfer_init_cmd(spi_xfer* pXfer, uint32_t header, uint8_t headerLength, uint8_t* pRxData, uint32_t rxLength) {
+    pXfer->pSegments          = NULL;
+    pXfer->numSegments        = 0;
+    pXfer->header             = header;
+    pXfer->headerLength       = headerLength;
+    pXfer->segment.pData      = pRxData;
+    pXfer->segment.byteLength = rxLength;
+    pXfer->pCallback          = NULL;
+}
+
+static void xfer_init_segments(spi_xfer* pXfer, const spi_segment* pSegments, uint32_t numSegments, spi_xfer_complete_fn* pCallback) {
+    pXfer->pSegments    = pSegments;
+    pXfer->numSegments  = numSegments;
+    pXfer->headerLength = 0;
+    pXfer->pCallback    = pCallback;
+}
+
+static void xfer_init_segment(spi_xfer* pXfer, bool rw_n, uint32_t addr, uint8_t* pData, uint32_t byteLength, spi_xfer_complete_fn* pCallback) {
+    pXfer->segment.rw_n       = rw_n;
+    pXfer->segment.addr       = addr;
+    pXfer->segment.pData      = pData;
+    pXfer->segment.byteLength = byteLength;
+
+    xfer_init_segments(pXfer, &pXfer->segment, 1, pCallback);
+}
+
+static void xfer_blocking(spi_xfer* pXfer) {
+    link_enqueue(pXfer);
+    spi_xfer_wait(pXfer);
+}
+
+uint8_t spi_read_at(uint32_t addr) {
+    // A one byte counted burst.  A following 'spi_read_next' returns the byte at 'addr + 1'.
+    uint8_t data;
+    spi_read_burst(&data, addr, 1);
+    return data;
+}
+
+uint8_t spi_read_next() {
+    // READ_NEXT returns the byte at the current address (i.e., following the previous read) in
+    // the byte following the command, then advances the address.
+    uint8_t data;
+    spi_xfer xfer;
+    xfer_init_cmd(&xfer, (uint32_t) SPI_CMD_READ_NEXT << 24, 1, &data, 1);
+    xfer_blocking(&xfer);
+    return data;
+}
+
+void spi_read_burst(uint8_t* pDest, uint32_t src, uint32_t byteLength) {
+    spi_xfer xfer;
+    xfer_init_segment(&xfer, /* rw_n: */ true, src, pDest, byteLength, NULL);
+    xfer_blocking(&xfer);
+}
+
+void spi_read(uint8_t* pDest, uint32_t src, uint32_t byteLength) {
+    spi_read_burst(pDest, src, byteLength);
 }
 
 void spi_write_at(uint32_t addr, uint8_t data) {
     const uint8_t cmd = SPI_CMD_WRITE_AT | addr >> 16;
     const uint8_t addr_hi = addr >> 8;
     const uint8_t addr_lo = addr & 0xff;
-    const uint8_t tx [] = { cmd, data, addr_hi, addr_lo };
 
-    cmd_start();
-    spi_write_blocking(SPI_INSTANCE, tx, sizeof(tx));
-    cmd_end();
+    spi_xfer xfer;
+    xfer_init_cmd(&xfer, (uint32_t) cmd << 24 | data << 16 | addr_hi << 8 | addr_lo, 4, NULL, 0);
+    xfer_blocking(&xfer);
 }
 
 void spi_write_next(uint8_t data) {
-    const uint8_t tx [] = { SPI_CMD_WRITE_NEXT, data };
+    spi_xfer xfer;
+    xfer_init_cmd(&xfer, (uint32_t) SPI_CMD_WRITE_NEXT << 24 | data << 16, 2, NULL, 0);
+    xfer_blocking(&xfer);
+}
 
-    cmd_start();
-    spi_write_blocking(SPI_INSTANCE, tx, sizeof(tx));
-    cmd_end();
+// AND_AT, OR_AT and XOR_AT return the original byte in the byte following the address.
+static uint8_t spi_rmw_at(uint8_t cmd, uint32_t addr, uint8_t mask) {
+    cmd |= addr >> 16;
+    const uint8_t addr_hi = addr >> 8;
+    const uint8_t addr_lo = addr & 0xff;
+
+    uint8_t data;
+    spi_xfer xfer;
+    xfer_init_cmd(&xfer, (uint32_t) cmd << 24 | mask << 16 | addr_hi << 8 | addr_lo, 4, &data, 1);
+    xfer_blocking(&xfer);
+    return data;
+}
+
+uint8_t spi_and_at(uint32_t addr, uint8_t mask) {
+    return spi_rmw_at(SPI_CMD_AND_AT, addr, mask);
+}
+
+uint8_t spi_or_at(uint32_t addr, uint8_t mask) {
+    return spi_rmw_at(SPI_CMD_OR_AT, addr, mask);
+}
+
+uint8_t spi_xor_at(uint32_t addr, uint8_t mask) {
+    return spi_rmw_at(SPI_CMD_XOR_AT, addr, mask);
+}
+
+void spi_write_burst(uint32_t dest, const uint8_t const* pSrc, uint32_t byteLength) {
+    spi_xfer xfer;
+    xfer_init_segment(&xfer, /* rw_n: */ false, dest, (uint8_t*) pSrc, byteLength, NULL);
+    xfer_blocking(&xfer);
 }
 
 void spi_write(uint32_t dest, const uint8_t const* pSrc, uint32_t byteLength) {
-    const uint8_t* p = pSrc;
-    
-    if (byteLength--) {
-        spi_write_at(dest, *p++);
+    spi_write_burst(dest, pSrc, byteLength);
+}
 
-        while (byteLength--) {
-            spi_write_next(*p++);
-        }
+void spi_batch(const spi_segment* pSegments, uint32_t numSegments) {
+    spi_xfer xfer;
+    xfer_init_segments(&xfer, pSegments, numSegments, NULL);
+    xfer_blocking(&xfer);
+}
+
+// DMA engine operations (see 'spi_dma' in the FPGA).
+#define FPGA_DMA_COPY       0
+#define FPGA_DMA_FILL       1
+#define FPGA_DMA_COMPARE    2
+#define FPGA_DMA_CRC        3
+#define FPGA_DMA_MARCH      4
+
+// MARCH flags in the FILL register.
+#define FPGA_MARCH_VALUE        (1 << 0)    // Expected bit value
+#define FPGA_MARCH_DESCENDING   (1 << 1)    // Visit addresses in descending order
+#define FPGA_MARCH_READ_ONLY    (1 << 2)    // Verify without inverting
+
+// Starts a DMA engine operation and waits for it to complete.  Returns the status register.
+static uint8_t spi_dma_run(uint8_t op, uint32_t dest, uint32_t src, uint8_t fill, uint32_t byteLength) {
+    // Writing the high byte of the length starts the operation, so the whole descriptor is a
+    // single burst command.  (A length of 65536 is written as 0.)
+    const uint8_t desc[] = {
+        src,  src >> 8,  src >> 16,
+        dest, dest >> 8, dest >> 16,
+        fill, op,
+        byteLength, byteLength >> 8
+    };
+
+    spi_write_burst(FPGA_REG_DMA, desc, sizeof(desc));
+
+    // Reads wait for preceding writes to reach the bus, so the first poll observes the operation.
+    uint8_t status;
+    do {
+        spi_read_burst(&status, FPGA_REG_DMA_STATUS, sizeof(status));
+    } while (status & FPGA_DMA_BUSY);
+
+    return status;
+}
+
+void spi_copy(uint32_t dest, uint32_t src, uint32_t byteLength) {
+    spi_dma_run(FPGA_DMA_COPY, dest, src, /* fill: */ 0, byteLength);
+}
+
+void spi_fill(uint32_t dest, uint8_t value, uint32_t byteLength) {
+    spi_dma_run(FPGA_DMA_FILL, dest, /* src: */ 0, value, byteLength);
+}
+
+bool spi_compare(uint32_t a, uint32_t b, uint32_t byteLength, uint32_t* pMismatch) {
+    if (!(spi_dma_run(FPGA_DMA_COMPARE, /* dest: */ b, /* src: */ a, /* fill: */ 0, byteLength) & FPGA_DMA_MISMATCH)) {
+        return true;
+    }
+
+    if (pMismatch) {
+        uint8_t addr[3];
+        spi_read_burst(addr, FPGA_REG_DMA_DST, sizeof(addr));
+        *pMismatch = (addr[2] & 1) << 16 | addr[1] << 8 | addr[0];
+    }
+
+    return false;
+}
+
+uint32_t spi_crc32(uint32_t addr, uint32_t byteLength) {
+    spi_dma_run(FPGA_DMA_CRC, /* dest: */ 0, /* src: */ addr, /* fill: */ 0, byteLength);
+
+    uint8_t crc[4];
+    spi_read_burst(crc, FPGA_REG_DMA_CRC, sizeof(crc));
+    return crc[3] << 24 | crc[2] << 16 | crc[1] << 8 | crc[0];
+}
+
+bool spi_march(uint32_t start, uint32_t byteLength, bool value, bool descending, bool readOnly, spi_march_fault* pFault) {
+    const uint8_t flags = (value ? FPGA_MARCH_VALUE : 0)
+        | (descending ? FPGA_MARCH_DESCENDING : 0)
+        | (readOnly ? FPGA_MARCH_READ_ONLY : 0);
+
+    const uint8_t status = spi_dma_run(FPGA_DMA_MARCH, /* dest: */ start, /* src: */ 0, flags, byteLength);
+    if (!(status & FPGA_DMA_MISMATCH)) {
+        return true;
     }
+
+    if (pFault) {
+        // DST (3 bytes) is followed by FILL ... ACTUAL in the register page.
+        uint8_t regs[FPGA_REG_DMA_ACTUAL - FPGA_REG_DMA_DST + 1];
+        spi_read_burst(regs, FPGA_REG_DMA_DST, sizeof(regs));
+        pFault->addr = (regs[2] & 1) << 16 | regs[1] << 8 | regs[0];
+        pFault->bit = (status >> FPGA_DMA_BIT_SHIFT) & 7;
+        pFault->actual = regs[sizeof(regs) - 1];
+    }
+
+    return false;
 }
 
 void set_cpu(bool reset, bool run) {
     spi_write_at(0xE80F,
         (reset ? 0 : (1 << 0))          // res_b
-        | (run ? (1 << 1) : 0));        // rdy
+        | (run ? (1 << 1) : 0)          // rdy
+        | (PET_80_COL << 2));           // 80 column video (must match the EDIT ROM)
     
     sleep_ms(1);
 }
+
+void spi_read_async(spi_xfer* pXfer, uint8_t* pDest, uint32_t src, uint32_t byteLength, spi_xfer_complete_fn* pCallback) {
+    xfer_init_segment(pXfer, /* rw_n: */ true, src, pDest, byteLength, pCallback);
+    link_enqueue(pXfer);
+}
+
+void spi_write_async(spi_xfer* pXfer, uint32_t dest, const uint8_t* pSrc, uint32_t byteLength, spi_xfer_complete_fn* pCallback) {
+    xfer_init_segment(pXfer, /* rw_n: */ false, dest, (uint8_t*) pSrc, byteLength, pCallback);
+    link_enqueue(pXfer);
+}
+
+void spi_batch_async(spi_xfer* pXfer, const spi_segment* pSegments, uint32_t numSegments, spi_xfer_complete_fn* pCallback) {
+    xfer_init_segments(pXfer, pSegments, numSegments, pCallback);
+    link_enqueue(pXfer);
+}
+
+bool spi_xfer_done(const spi_xfer* pXfer) {
+    return pXfer->done;
+}
+
+void spi_xfer_wait(const spi_xfer* pXfer) {
+    while (!pXfer->done) {
+        tight_loop_contents();
+    }
+}
+
+void spi_async_flush() {
+    while (link.pActive != NULL) {
+        tight_loop_contents();
+    }
+}
+
+uint8_t spi_status() {
+    return link.status;
+}
+
+void spi_link_stats_get(spi_link_stats* pStats) {
+    const uint32_t status = save_and_disable_interrupts();
+    *pStats = link.stats;
+    restore_interrupts(status);
+}
+
+void spi_link_stats_reset() {
+    const uint32_t status = save_and_disable_interrupts();
+    link.stats = (spi_link_stats) { 0 };
+    restore_interrupts(status);
+}
@@ -19,11 +19,125 @@
 void driver_init();
 
 void spi_read(uint8_t* pDest, uint32_t src, uint32_t byteLength);
+void spi_read_burst(uint8_t* pDest, uint32_t src, uint32_t byteLength);
 uint8_t spi_read_at(uint32_t addr);
 uint8_t spi_read_next();
 
 void spi_write(uint32_t dest, const uint8_t const* pSrc, uint32_t byteLength);
+void spi_write_burst(uint32_t dest, const uint8_t const* pSrc, uint32_t byteLength);
 void spi_write_at(uint32_t addr, uint8_t data);
 void spi_write_next(uint8_t data);
 
+// Atomically replaces the byte at 'addr' with 'byte & mask', 'byte | mask' or 'byte ^ mask' and
+// returns the original byte.  The CPU cannot access the byte between the read and the write.
+uint8_t spi_and_at(uint32_t addr, uint8_t mask);
+uint8_t spi_or_at(uint32_t addr, uint8_t mask);
+uint8_t spi_xor_at(uint32_t addr, uint8_t mask);
+
 void set_cpu(bool reset, bool run);
+
+// Bulk memory operations performed by the FPGA using bus slots left idle by SPI.  Each is
+// started with a single SPI command and waits for completion.  Lengths are 1..65536 bytes.
+// Bytes whose source or destination falls in an $xE8xx page (the I/O page or the FPGA register
+// page) are skipped.
+void spi_copy(uint32_t dest, uint32_t src, uint32_t byteLength);
+void spi_fill(uint32_t dest, uint8_t value, uint32_t byteLength);
+
+// Returns true if the ranges match.  Otherwise, stores the address of the first mismatched byte
+// in 'b' to 'pMismatch' (if not NULL).
+bool spi_compare(uint32_t a, uint32_t b, uint32_t byteLength, uint32_t* pMismatch);
+
+// Returns the CRC-32 of the given range (as zlib's 'crc32()', skipping $xE8xx pages).
+uint32_t spi_crc32(uint32_t addr, uint32_t byteLength);
+
+// Runs one element of a byte-wide March test over 'byteLength' bytes starting at 'start' (the
+// highest address when 'descending').  All bits of each byte are verified to equal 'value' and,
+// unless 'readOnly', the byte is then inverted.  Returns true if no bit failed.  Otherwise,
+// stores the first failure to 'pFault' (if not NULL).  The failing bit is the first mismatched
+// bit in visiting order (the lowest bit, or the highest when 'descending').
+typedef struct {
+    uint32_t addr;                      // Address of failing byte
+    uint8_t bit;                        // Failing bit
+    uint8_t actual;                     // Byte read
+} spi_march_fault;
+
+bool spi_march(uint32_t start, uint32_t byteLength, bool value, bool descending, bool readOnly, spi_march_fault* pFault);
+
+// Asynchronous transfers are queued and executed in the background by PIO and DMA.  Blocking
+// calls above are queued behind pending asynchronous transfers and wait for completion.
+//
+// Completion callbacks are invoked from an interrupt handler and must not call the blocking
+// functions above.  The 'spi_xfer' and its buffer must remain valid until the transfer is done.
+
+typedef struct spi_xfer spi_xfer;
+typedef void spi_xfer_complete_fn(spi_xfer* pXfer);
+
+// A contiguous range of bus addresses to read or write.  A transfer executes a list of
+// segments as a single CS_N frame (or as few frames as possible for long lists), so a batch of
+// small, scattered accesses costs one interrupt rather than one per access.
+typedef struct {
+    bool rw_n;                          // Direction (false = write, true = read)
+    uint32_t addr;                      // 17-bit bus address of first byte
+    uint8_t* pData;                     // Source (write) or destination (read) buffer
+    uint32_t byteLength;
+} spi_segment;
+
+struct spi_xfer {
+    const spi_segment* pSegments;       // Segments to transfer, in order
+    uint32_t numSegments;
+    spi_xfer_complete_fn* pCallback;    // Optional callback invoked on completion (may be NULL)
+    void* pContext;                     // Caller-defined
+
+    volatile bool done;                 // Set when the transfer has completed
+    spi_xfer* pNext;                    // Next transfer in queue (internal)
+
+    spi_segment segment;                // Storage for single segment transfers (internal)
+    uint32_t header;                    // Non-burst command and argument bytes, left-justified (internal)
+    uint8_t headerLength;               // Number of non-burst header bytes, or 0 (internal)
+};
+
+void spi_read_async(spi_xfer* pXfer, uint8_t* pDest, uint32_t src, uint32_t byteLength, spi_xfer_complete_fn* pCallback);
+void spi_write_async(spi_xfer* pXfer, uint32_t dest, const uint8_t* pSrc, uint32_t byteLength, spi_xfer_complete_fn* pCallback);
+void spi_batch_async(spi_xfer* pXfer, const spi_segment* pSegments, uint32_t numSegments, spi_xfer_complete_fn* pCallback);
+void spi_batch(const spi_segment* pSegments, uint32_t numSegments);
+bool spi_xfer_done(const spi_xfer* pXfer);
+void spi_xfer_wait(const spi_xfer* pXfer);
+void spi_async_flush();
+
+// The FPGA returns a status byte during the command byte of every SPI command.  'spi_status'
+// returns the status byte received by the most recently completed transfer, so callers that
+// already exchange data with the FPGA do not need to poll for status.
+#define SPI_STATUS_GFX      (1 << 0)    // Graphics character set selected
+#define SPI_STATUS_VSYNC    (1 << 1)    // Video is in vertical sync
+#define SPI_STATUS_FRAME    (1 << 2)    // Toggles at the start of each vertical sync
+#define SPI_STATUS_CPU_RES  (1 << 3)    // CPU is held in reset
+#define SPI_STATUS_CPU_RDY  (1 << 4)    // CPU is running
+
+uint8_t spi_status();
+
+// SPI-only register page (not visible to the CPU).
+#define FPGA_REG_BASE           0x1e800
+#define FPGA_REG_VRAM_DIRTY     (FPGA_REG_BASE + 0x00)  // 8 bytes: 1 bit per 32 bytes of $8000-$87FF, read clears
+#define FPGA_REG_CHARS_DIRTY    (FPGA_REG_BASE + 0x08)  // 8 bytes: 1 bit per 32 bytes of $8800-$8FFF, read clears
+#define FPGA_VRAM_DIRTY_CHUNK   32                      // Bytes of RAM per dirty bit
+#define FPGA_REG_CRTC           (FPGA_REG_BASE + 0x20)  // 32 bytes: CRTC registers R0..R31 (read only)
+#define FPGA_REG_DMA            (FPGA_REG_BASE + 0x50)  // 10 bytes: DMA engine src, dst, fill, op, and length (writing length starts)
+#define FPGA_REG_DMA_DST        (FPGA_REG_BASE + 0x53)  // 3 bytes: next (or mismatched) destination address
+#define FPGA_REG_DMA_STATUS     (FPGA_REG_BASE + 0x5a)  // 1 byte: DMA engine status
+#define FPGA_DMA_BUSY           (1 << 0)                // Operation in progress
+#define FPGA_DMA_MISMATCH       (1 << 1)                // COMPARE or MARCH stopped at a mismatch
+#define FPGA_DMA_BIT_SHIFT      4                       // Failing bit (MARCH) in bits 4-6
+#define FPGA_REG_DMA_CRC        (FPGA_REG_BASE + 0x5b)  // 4 bytes: CRC-32 from last CRC operation, little endian
+#define FPGA_REG_DMA_ACTUAL     (FPGA_REG_BASE + 0x5f)  // 1 byte: byte read at COMPARE or MARCH mismatch
+
+// Link utilization counters, accumulated since the last reset.
+typedef struct {
+    uint32_t frames;                    // CS_N frames (one interrupt each)
+    uint32_t commands;                  // Commands issued
+    uint32_t payloadBytes;              // Data bytes transferred
+    uint32_t overheadBytes;             // Command, address and length bytes
+    uint32_t busyUs;                    // Time spent with a frame in progress
+} spi_link_stats;
+
+void spi_link_stats_get(spi_link_stats* pStats);
+void spi_link_stats_reset();
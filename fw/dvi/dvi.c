@@ -23,6 +23,25 @@ const struct dvi_timing __not_in_flash_func(dvi_timing_720x480p_60hz) = {
 	.bit_clk_khz       = 270000
 };
 
+// 720x576p @ 50 Hz (270 MHz)
+// CEA timing for 50 Hz displays.  Shares the 27 MHz pixel clock with 720x480p, so either may
+// be selected without changing clk_sys.
+const struct dvi_timing __not_in_flash_func(dvi_timing_720x576p_50hz) = {
+	.h_sync_polarity   = false,
+	.h_front_porch     = 12,
+	.h_sync_width      = 64,
+	.h_back_porch      = 68,
+	.h_active_pixels   = 720,
+
+	.v_sync_polarity   = false,
+	.v_front_porch     = 5,
+	.v_sync_width      = 5,
+	.v_back_porch      = 39,
+	.v_active_lines    = 576,
+
+	.bit_clk_khz       = 270000
+};
+
 // For Monochrome:
 //    # target_compile_definitions(firmware PRIVATE
 //    #     DVI_VERTICAL_REPEAT=1
@@ -36,11 +55,20 @@ const struct dvi_timing __not_in_flash_func(dvi_timing_720x480p_60hz) = {
 // #define OFFSET_X 20
 // #define OFFSET_Y 20
 
+#if PET_80_COL
+// 80 columns x 8 pixels at 720 pixels per line, encoded with the 1bpp monochrome pipeline.
+#define FRAME_WIDTH 720
+#define OFFSET_X 40
+#else
 #define FRAME_WIDTH 360
-#define FRAME_HEIGHT 240
-#define DVI_TIMING dvi_timing_720x480p_60hz
 #define OFFSET_X 20
-#define OFFSET_Y 20
+#endif
+
+// The DVI timing (and therefore the frame height) is selected at runtime to match the PET's
+// frame period (see 'video_init').
+#define FRAME_HEIGHT_MAX (576 / DVI_VERTICAL_REPEAT)
+
+static uint frame_height;
 
 // #define FRAME_WIDTH 320
 // #define FRAME_HEIGHT 240
@@ -53,8 +81,116 @@ const struct dvi_timing __not_in_flash_func(dvi_timing_720x480p_60hz) = {
 struct dvi_inst dvi0;
 struct semaphore dvi_start_sem;
 
-#define CHAR_COLS 40
-#define CHAR_ROWS 25
+#define CHAR_COLS VIDEO_CHAR_COLS
+#define CHAR_ROWS VIDEO_CHAR_ROWS
+
+// Display layout, precomputed from the CRTC registers by core 0 whenever they change so that
+// scanlines need only a table lookup to find their characters and font row.
+//
+//   R1  (H Displayed)   Characters per row (in 80 column mode, each address is 2 characters)
+//   R6  (V Displayed)   Rows per frame
+//   R9  (Scan Lines)    Scan lines per row, minus one.  Lines past the 8 line font are blank.
+//   R12/R13 (Start)     Display RAM address of the first character
+//
+// The displayed rows are centered vertically and clipped to the frame.
+#define LAYOUT_BLANK 0xff
+
+typedef struct {
+    uint16_t offset[FRAME_HEIGHT_MAX];          // Offset of the line's first character in 'chars'
+    uint8_t  font_row[FRAME_HEIGHT_MAX];        // Font row for the line, or LAYOUT_BLANK
+    uint8_t  cols;                              // Displayed characters per line
+} video_layout;
+
+static void layout_init(video_layout* pLayout, const uint8_t* crtc) {
+    const uint32_t col_shift  = PET_80_COL;
+    const uint32_t ma_per_row = crtc[1];
+    const uint32_t rows       = crtc[6] & 0x7f;
+    const uint32_t scan_lines = (crtc[9] & 0x1f) + 1;
+    const uint32_t start      = (crtc[12] << 8) | crtc[13];
+
+    const uint32_t cols = ma_per_row << col_shift;
+    pLayout->cols = cols < CHAR_COLS ? cols : CHAR_COLS;
+
+    uint32_t height = rows * scan_lines;
+    if (height > frame_height) {
+        height = frame_height;
+    }
+
+    const uint32_t top = (frame_height - height) / 2;
+
+    for (uint32_t y = 0; y < frame_height; y++) {
+        pLayout->offset[y]   = 0;
+        pLayout->font_row[y] = LAYOUT_BLANK;
+
+        if (top <= y && y < top + height) {
+            const uint32_t line = y - top;
+            const uint32_t ra   = line % scan_lines;
+
+            if (ra < FONT_CHAR_HEIGHT) {
+                const uint32_t ma = start + line / scan_lines * ma_per_row;
+                pLayout->offset[y]   = (ma << col_shift) & (VIDEO_CHAR_BUFFER_BYTE_SIZE - 1);
+                pLayout->font_row[y] = ra;
+            }
+        }
+    }
+}
+
+// Screen snapshots are triple buffered so that a frame never mixes two PET screen states.  Core 0
+// fills the back buffer and publishes it by swapping it with the ready buffer.  At the start of
+// each frame, core 1 swaps the ready buffer with the front buffer if a new snapshot was published.
+//
+// The Cortex-M0+ has no atomic exchange, so the swaps are guarded by a hardware spin lock.  The
+// lock is held only for the swap itself (never while copying or rendering).
+typedef struct {
+    uint8_t chars[VIDEO_CHAR_BUFFER_BYTE_SIZE + CHAR_COLS];     // Display RAM, followed by a copy of its
+                                                                // start so rows that wrap are contiguous
+    uint8_t crtc[VIDEO_CRTC_REG_COUNT];                         // CRTC registers R0..R15
+    video_layout layout;                                        // Layout derived from 'crtc'
+    uint32_t published_us;                                      // Time of 'video_publish'
+} video_snapshot;
+
+static video_snapshot snapshots[3];
+static uint8_t snapshot_back  = 0;             // Owned by core 0
+static uint8_t snapshot_ready = 1;             // Guarded by 'snapshot_lock'
+static uint8_t snapshot_front = 2;             // Owned by core 1
+static bool    snapshot_fresh = false;         // Guarded by 'snapshot_lock'
+static spin_lock_t* snapshot_lock;
+
+void video_publish(const uint8_t* pChars, const uint8_t* pCrtc) {
+    video_snapshot* const pBack = &snapshots[snapshot_back];
+    memcpy(pBack->chars, pChars, VIDEO_CHAR_BUFFER_BYTE_SIZE);
+    memcpy(pBack->chars + VIDEO_CHAR_BUFFER_BYTE_SIZE, pChars, CHAR_COLS);
+
+    // The layout is computed here rather than by core 1, where it would overrun the scanline
+    // budget.  It is only recomputed if the back buffer was laid out for different registers.
+    if (memcmp(pBack->crtc, pCrtc, VIDEO_CRTC_REG_COUNT) != 0) {
+        memcpy(pBack->crtc, pCrtc, VIDEO_CRTC_REG_COUNT);
+        layout_init(&pBack->layout, pCrtc);
+    }
+
+    pBack->published_us = time_us_32();
+
+    const uint32_t save = spin_lock_blocking(snapshot_lock);
+    const uint8_t ready = snapshot_ready;
+    snapshot_ready = snapshot_back;
+    snapshot_fresh = true;
+    spin_unlock(snapshot_lock, save);
+
+    snapshot_back = ready;
+}
+
+static inline const video_snapshot* __not_in_flash_func(snapshot_latch)() {
+    const uint32_t save = spin_lock_blocking(snapshot_lock);
+    if (snapshot_fresh) {
+        const uint8_t front = snapshot_front;
+        snapshot_front = snapshot_ready;
+        snapshot_ready = front;
+        snapshot_fresh = false;
+    }
+    spin_unlock(snapshot_lock, save);
+
+    return &snapshots[snapshot_front];
+}
 
 static inline uint16_t __not_in_flash_func(stretch_x)(uint16_t x) {
     x = (x | (x << 4)) & 0x0F0F;
@@ -165,52 +301,226 @@ static inline void prepare_scanline(const char *chars, int y) {
 }
 */
 
-static inline void __not_in_flash_func(prepare_scanline)(const char *chars, int16_t y) {
-	static uint16_t __attribute__((aligned(4))) scanline[FRAME_WIDTH];
+#if PET_80_COL
+// In 80 column mode, font bytes are the 1bpp pixels (leftmost pixel in the MSB, see
+// 'DVI_1BPP_BIT_REVERSE'), so the scanline is a straight byte copy followed by PicoDVI's
+// monochrome encoder, which produces a single channel shared by all three TMDS lanes.
+static_assert((OFFSET_X % FONT_CHAR_WIDTH) == 0, "Character cells must be byte aligned in the scanline.");
 
-    y -= OFFSET_Y;
+// Encodes a scanline from the given font bytes (one per column).
+static inline void __not_in_flash_func(tmds_encode_row)(uint32_t* tmdsbuf, const uint8_t* row) {
+    static uint8_t __attribute__((aligned(4))) scanline[FRAME_WIDTH / 8];
 
-    if (y < 0 || y >= 200) {
-        memset(scanline, 0x00, sizeof(scanline));
-    } else {
-        uint16_t x = OFFSET_X;
+    memcpy(scanline + OFFSET_X / 8, row, CHAR_COLS);
+    tmds_encode_1bpp((const uint32_t*) scanline, tmdsbuf, FRAME_WIDTH);
+}
+#else
+// TMDS symbols for each font byte value, per channel (blue, green, red).  The PicoDVI encoder emits
+// DC balanced symbols whose value depends only on the pixel (not on running disparity), so an
+// 8-pixel glyph slice encodes to the same 8 words wherever it appears.  Visible scanlines are
+// assembled by copying cached words into the TMDS buffer, bypassing the encoder.  Reverse video
+// is handled by inverting the font byte before the lookup.
+#define TMDS_CHANNELS 3
+
+static uint32_t tmds_glyphs[TMDS_CHANNELS][256][FONT_CHAR_WIDTH];
+static uint32_t tmds_bg[TMDS_CHANNELS];
+
+static void tmds_glyphs_init(uint16_t fg, uint16_t bg) {
+    // Channel bit ranges within an RGB565 pixel (see 'encode_rgb565').
+    static const uint8_t msb[TMDS_CHANNELS] = { 4, 10, 15 };
+    static const uint8_t lsb[TMDS_CHANNELS] = { 0,  5, 11 };
+
+    for (uint32_t p8 = 0; p8 < 256; p8++) {
+        uint16_t __attribute__((aligned(4))) pixels[FONT_CHAR_WIDTH];
+
+        for (uint32_t i = 0; i < FONT_CHAR_WIDTH; i++) {
+            pixels[i] = (p8 & (0x80 >> i)) ? fg : bg;
+        }
+
+        for (uint32_t ch = 0; ch < TMDS_CHANNELS; ch++) {
+            tmds_encode_data_channel_16bpp((const uint32_t*) pixels, tmds_glyphs[ch][p8], FONT_CHAR_WIDTH, msb[ch], lsb[ch]);
+        }
+    }
 
-        for (uint8_t col = 0; col < CHAR_COLS; col++) {
-            char ch = chars[col + y / FONT_CHAR_HEIGHT * CHAR_COLS];
-            
-            bool reverse = ch & 0x80;
-            ch &= 0x7f;
+    for (uint32_t ch = 0; ch < TMDS_CHANNELS; ch++) {
+        tmds_bg[ch] = tmds_glyphs[ch][0][0];
+    }
+}
 
-            uint8_t p8 = p_video_font[ch * FONT_CHAR_HEIGHT + (y % FONT_CHAR_HEIGHT)];
-            if (reverse) {
-                p8 ^= 0xff;
-            }
+static inline void __not_in_flash_func(tmds_fill)(uint32_t* pDest, uint32_t symbol, uint32_t count) {
+    while (count--) {
+        *pDest++ = symbol;
+    }
+}
 
-            const uint16_t fg = 0x07e4;
-            const uint16_t bg = 0x0000;
-
-            scanline[x++] = (p8 & 0x80) ? fg : bg;
-            scanline[x++] = (p8 & 0x40) ? fg : bg;
-            scanline[x++] = (p8 & 0x20) ? fg : bg;
-            scanline[x++] = (p8 & 0x10) ? fg : bg;
-            scanline[x++] = (p8 & 0x08) ? fg : bg;
-            scanline[x++] = (p8 & 0x04) ? fg : bg;
-            scanline[x++] = (p8 & 0x02) ? fg : bg;
-            scanline[x++] = (p8 & 0x01) ? fg : bg;
-    	}
+// Encodes a scanline from the given font bytes (one per column).
+static inline void __not_in_flash_func(tmds_encode_row)(uint32_t* tmdsbuf, const uint8_t* row) {
+    for (uint32_t ch = 0; ch < TMDS_CHANNELS; ch++) {
+        uint32_t* pDest = tmdsbuf + ch * FRAME_WIDTH;
+
+        tmds_fill(pDest, tmds_bg[ch], OFFSET_X);
+        pDest += OFFSET_X;
+
+        for (uint32_t col = 0; col < CHAR_COLS; col++) {
+            const uint32_t* pSrc = tmds_glyphs[ch][row[col]];
+
+            *pDest++ = pSrc[0];
+            *pDest++ = pSrc[1];
+            *pDest++ = pSrc[2];
+            *pDest++ = pSrc[3];
+            *pDest++ = pSrc[4];
+            *pDest++ = pSrc[5];
+            *pDest++ = pSrc[6];
+            *pDest++ = pSrc[7];
+        }
+
+        tmds_fill(pDest, tmds_bg[ch], FRAME_WIDTH - OFFSET_X - CHAR_COLS * FONT_CHAR_WIDTH);
+    }
+}
+
+#endif
+
+// PicoDVI recycles a small set of TMDS buffers through its free/valid queues.  Each buffer is
+// tagged with the font bytes it was last encoded from.  When a buffer returns holding the same
+// font bytes as the next scanline (e.g., borders, blank or repeated text rows), it is requeued
+// without re-encoding.  (Blank lines are tagged as a row of all zero font bytes, which encodes
+// to the same background symbols.)
+#define TMDS_LINE_TAGS 8                // Must be >= DVI_N_TMDS_BUFFERS
+
+typedef struct {
+    const uint32_t* pBuf;               // TMDS buffer
+    bool valid;                         // 'row' describes the buffer's contents
+    uint32_t row[CHAR_COLS / 4];        // Font bytes the buffer was encoded from
+} tmds_line_tag;
+
+static tmds_line_tag tmds_line_tags[TMDS_LINE_TAGS];
+static uint32_t tmds_line_tag_count = 0;
+
+static inline tmds_line_tag* __not_in_flash_func(tmds_line_tag_find)(const uint32_t* pBuf) {
+    for (uint32_t i = 0; i < tmds_line_tag_count; i++) {
+        if (tmds_line_tags[i].pBuf == pBuf) {
+            return &tmds_line_tags[i];
+        }
+    }
+
+    if (tmds_line_tag_count == TMDS_LINE_TAGS) {
+        panic("More than %d TMDS buffers in circulation.", TMDS_LINE_TAGS);
+    }
+
+    tmds_line_tag* pTag = &tmds_line_tags[tmds_line_tag_count++];
+    pTag->pBuf  = pBuf;
+    pTag->valid = false;
+    return pTag;
+}
+
+// Prepares the given scanline in 'tmdsbuf'.  Returns true if the buffer already held it.
+static inline bool __not_in_flash_func(prepare_scanline)(uint32_t* tmdsbuf, const video_snapshot* pSnapshot, uint y) {
+    // Font bytes for this scanline, with reverse video applied (bit 7 of the character).
+    uint32_t row_words[CHAR_COLS / 4] = { 0 };
+    uint8_t* const row = (uint8_t*) row_words;
+
+    const video_layout* const pLayout = &pSnapshot->layout;
+    const uint8_t font_row = pLayout->font_row[y];
+
+    if (font_row != LAYOUT_BLANK) {
+        const uint8_t* pChars = pSnapshot->chars + pLayout->offset[y];
+        const uint8_t* pFont  = p_video_font + font_row;
+        const uint32_t cols   = pLayout->cols;
+
+        for (uint32_t col = 0; col < cols; col++) {
+            const uint8_t c = pChars[col];
+            row[col] = pFont[(c & 0x7f) * FONT_CHAR_HEIGHT] ^ (uint8_t) ((int8_t) c >> 7);
+        }
     }
 
-    encode_rgb565(scanline);
+    tmds_line_tag* const pTag = tmds_line_tag_find(tmdsbuf);
+    const bool reused = pTag->valid && memcmp(pTag->row, row_words, sizeof(row_words)) == 0;
+
+    if (!reused) {
+        tmds_encode_row(tmdsbuf, row);
+        memcpy(pTag->row, row_words, sizeof(row_words));
+        pTag->valid = true;
+    }
+
+    return reused;
+}
+
+// Scanline render time is measured with core 1's SysTick (a 24-bit down counter at clk_sys).
+static volatile uint32_t render_lines;
+static volatile uint32_t render_reused_lines;
+static volatile uint32_t render_cycles;
+static volatile uint32_t render_max_cycles;
+static volatile uint32_t render_max_latency_us;
+
+void video_render_stats_get(video_render_stats* pStats) {
+    pStats->lines        = render_lines;
+    pStats->reusedLines  = render_reused_lines;
+    pStats->cycles       = render_cycles;
+    pStats->maxCycles    = render_max_cycles;
+    pStats->maxLatencyUs = render_max_latency_us;
+
+    // The scanline callback runs once per 'DVI_VERTICAL_REPEAT' lines.  clk_sys runs at the TMDS
+    // bit clock, which is 10x the pixel clock.
+    const struct dvi_timing* const t = dvi0.timing;
+    pStats->budgetCycles = (t->h_front_porch + t->h_sync_width + t->h_back_porch + t->h_active_pixels)
+        * 10 * DVI_VERTICAL_REPEAT;
+}
+
+void video_render_stats_reset() {
+    render_lines          = 0;
+    render_reused_lines   = 0;
+    render_cycles         = 0;
+    render_max_cycles     = 0;
+    render_max_latency_us = 0;
 }
 
 void __not_in_flash_func(core1_scanline_callback)() {
     static uint y = 1;
-	prepare_scanline(video_char_buffer, y);
-	y = (y + 1) % FRAME_HEIGHT;
+    static const video_snapshot* pSnapshot = &snapshots[2];
+
+    // Only pick up a new snapshot (and its layout) between frames.
+    if (y == 0) {
+        const video_snapshot* const pLatched = snapshot_latch();
+
+        // Track the time from capture to the start of the first frame that displays it.
+        if (pLatched != pSnapshot) {
+            const uint32_t latency_us = time_us_32() - pLatched->published_us;
+            if (latency_us > render_max_latency_us) {
+                render_max_latency_us = latency_us;
+            }
+        }
+
+        pSnapshot = pLatched;
+    }
+
+	uint32_t* tmdsbuf;
+	queue_remove_blocking_u32(&dvi0.q_tmds_free, &tmdsbuf);
+
+    // Time only the rendering (not the wait for a free TMDS buffer above).
+    const uint32_t start = systick_hw->cvr;
+	const bool reused = prepare_scanline(tmdsbuf, pSnapshot, y);
+    const uint32_t cycles = (start - systick_hw->cvr) & 0xffffff;
+
+	queue_add_blocking_u32(&dvi0.q_tmds_valid, &tmdsbuf);
+
+    render_lines++;
+    render_reused_lines += reused;
+    render_cycles += cycles;
+    if (cycles > render_max_cycles) {
+        render_max_cycles = cycles;
+    }
+
+	y = (y + 1) % frame_height;
 }
 
 void core1_main() {
 	dvi_register_irqs_this_core(&dvi0, DMA_IRQ_0);
+
+    // Free running SysTick for 'video_render_stats'.
+    systick_hw->rvr = 0xffffff;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+
 	sem_acquire_blocking(&dvi_start_sem);
 	dvi_start(&dvi0);
 
@@ -220,20 +530,59 @@ void core1_main() {
 	__builtin_unreachable();
 }
 
-void video_init() {
+// The selected CEA timing with its vertical blanking adjusted to the PET's frame period.
+static struct dvi_timing dvi_timing_pet;
+
+// Most sinks accept a vertical total a few lines away from the CEA value.
+#define V_TOTAL_ADJUST_MAX 16
+
+void video_init(uint32_t pet_frame_us) {
+    // Start from the CEA timing nearest the PET's refresh rate.
+    dvi_timing_pet = pet_frame_us >= 1000000 / 55
+        ? dvi_timing_720x576p_50hz
+        : dvi_timing_720x480p_60hz;
+
+    // Then add or remove back porch lines so that the DVI frame period matches the PET's to
+    // within half a scan line (about 0.08% or 0.04 Hz), so that each PET frame is shown for
+    // exactly one DVI frame without a slow drift between the two.  (E.g., a 50.08 Hz EDIT ROM
+    // runs 576p50 at 624 rather than 625 lines.)
+    struct dvi_timing* const timing = &dvi_timing_pet;
+
+    const uint32_t h_total   = timing->h_front_porch + timing->h_sync_width + timing->h_back_porch + timing->h_active_pixels;
+    const uint32_t v_total   = timing->v_front_porch + timing->v_sync_width + timing->v_back_porch + timing->v_active_lines;
+    const uint32_t pixel_khz = timing->bit_clk_khz / 10;
+
+    int32_t v_delta = (int32_t) (((uint64_t) pet_frame_us * pixel_khz + h_total * 500) / (h_total * 1000)) - (int32_t) v_total;
+    if (v_delta < -V_TOTAL_ADJUST_MAX) v_delta = -V_TOTAL_ADJUST_MAX;
+    if (v_delta > V_TOTAL_ADJUST_MAX) v_delta = V_TOTAL_ADJUST_MAX;
+
+    timing->v_back_porch += v_delta;
+
     uint32_t f_clk_sys = frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_SYS);
-    int32_t delta      = f_clk_sys - DVI_TIMING.bit_clk_khz;
+    int32_t delta      = f_clk_sys - timing->bit_clk_khz;
     if (!(-1 <= delta && delta <= 1)) {
-        panic("FAIL: Incorrect clk_sys frequency.  Expected %d +/-1 kHz, but got %d kHz.", DVI_TIMING.bit_clk_khz, f_clk_sys);
+        panic("FAIL: Incorrect clk_sys frequency.  Expected %d +/-1 kHz, but got %d kHz.", timing->bit_clk_khz, f_clk_sys);
     }
 
-	dvi0.timing = &DVI_TIMING;
+    frame_height = timing->v_active_lines / DVI_VERTICAL_REPEAT;
+
+	dvi0.timing = timing;
 	dvi0.ser_cfg = micromod_cfg;
 	dvi0.scanline_callback = core1_scanline_callback;
 	dvi_init(&dvi0, next_striped_spin_lock_num(), next_striped_spin_lock_num());
 
-    memset(video_char_buffer, 0, sizeof(video_char_buffer));
-	prepare_scanline(video_char_buffer, 0);
+    snapshot_lock = spin_lock_init(spin_lock_claim_unused(/* required: */ true));
+#if !PET_80_COL
+    tmds_glyphs_init(/* fg: */ 0x07e4, /* bg: */ 0x0000);
+#endif
+    for (uint32_t i = 0; i < count_of(snapshots); i++) {
+        layout_init(&snapshots[i].layout, snapshots[i].crtc);
+    }
+
+	uint32_t* tmdsbuf;
+	queue_remove_blocking_u32(&dvi0.q_tmds_free, &tmdsbuf);
+	prepare_scanline(tmdsbuf, &snapshots[snapshot_front], 0);
+	queue_add_blocking_u32(&dvi0.q_tmds_valid, &tmdsbuf);
 
 	sem_init(&dvi_start_sem, 0, 1);
 	hw_set_bits(&bus_ctrl_hw->priority, BUSCTRL_BUS_PRIORITY_PROC1_BITS);
@@ -1,3 +1,26 @@
 #pragma once
 
-void video_init();
+// Starts DVI output using the timing that best matches the given PET frame period: 720x576p50
+// for 50 Hz EDIT ROMs, otherwise 720x480p60, with the vertical blanking adjusted to match the
+// PET's frame period to within half a scan line.
+void video_init(uint32_t pet_frame_us);
+
+#define VIDEO_CRTC_REG_COUNT 16
+
+// Publishes a copy of the given display RAM ('VIDEO_CHAR_BUFFER_BYTE_SIZE' bytes) and CRTC
+// registers ('VIDEO_CRTC_REG_COUNT' bytes) to the DVI core, which displays them starting with
+// the next frame.  Must be called from core 0.
+void video_publish(const uint8_t* pChars, const uint8_t* pCrtc);
+
+// Scanline render time on core 1 (clk_sys cycles), accumulated since the last reset.
+typedef struct {
+    uint32_t lines;                     // Scanlines rendered
+    uint32_t reusedLines;               // Scanlines requeued without re-encoding
+    uint32_t cycles;                    // Total cycles spent rendering (excludes waits for a free buffer)
+    uint32_t maxCycles;                 // Slowest scanline
+    uint32_t budgetCycles;              // Cycles available per scanline callback
+    uint32_t maxLatencyUs;              // Longest time from 'video_publish' to display
+} video_render_stats;
+
+void video_render_stats_get(video_render_stats* pStats);
+void video_render_stats_reset();
@@ -30,4 +30,7 @@ uint8_t key_matrix[10] = {
 
 uint8_t video_char_buffer[VIDEO_CHAR_BUFFER_BYTE_SIZE];
 
-uint8_t const* p_video_font;
+uint8_t video_font_buffer[VIDEO_FONT_BYTE_SIZE];
+
+// Core 1 begins rendering before the first snapshot is published, so never leave this NULL.
+uint8_t const* p_video_font = video_font_buffer;
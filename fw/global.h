@@ -16,8 +16,30 @@
 
 #include "pch.h"
 
-#define VIDEO_CHAR_BUFFER_BYTE_SIZE 1000
+// Set by the 'PET_80_COL' CMake option to build for the 80 column (8032) EDIT ROM, which also
+// selects the 80 column DVI renderer and the FPGA's 80 column mode (see 'set_cpu').
+#ifndef PET_80_COL
+#define PET_80_COL 0
+#endif
+
+#if PET_80_COL
+#define VIDEO_CHAR_COLS 80
+#else
+#define VIDEO_CHAR_COLS 40
+#endif
+
+#define VIDEO_CHAR_ROWS 25
+
+// Mirror of display RAM at $8000 (1KB in 40 column mode, 2KB in 80 column mode).  The CRTC start
+// address selects where in display RAM the screen begins.
+#define VIDEO_CHAR_BUFFER_BYTE_SIZE (PET_80_COL ? 2048 : 1024)
 
 extern uint8_t key_matrix[10];
 extern uint8_t video_char_buffer[VIDEO_CHAR_BUFFER_BYTE_SIZE];
+
+// SRAM copy of the character generator in PET RAM at $8800-$8FFF, so the DVI renderer never reads
+// fonts from flash.  'p_video_font' points to the selected half.
+#define VIDEO_FONT_BYTE_SIZE 2048
+
+extern uint8_t video_font_buffer[VIDEO_FONT_BYTE_SIZE];
 extern uint8_t const* p_video_font;
@@ -46,19 +46,25 @@ void init() {
     printf("SD initialized.\n");
     usb_init();
     printf("USB initialized.\n");
-    video_init();
-    printf("Video initialized.\n");
 }
 
 int main() {
     init();
 
 #ifdef TEST
+    video_init(/* pet_frame_us: */ 1000000 / 60);
+    printf("Video initialized.\n");
     test_ram();
     // test_display();
 #else
+    // DVI timing is chosen to match the frame period that the EDIT ROM programs into the CRTC.
     pet_reset();
     printf("PET reset.\n");
+
+    const uint32_t frame_us = pet_frame_us();
+    video_init(frame_us);
+    printf("Video initialized (PET frame %lu us).\n", frame_us);
+
     pet_main();
 #endif
 
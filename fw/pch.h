@@ -21,10 +21,12 @@
 #include "hardware/dma.h"
 #include "hardware/gpio.h"
 #include "hardware/irq.h"
+#include "hardware/pio.h"
 #include "hardware/pwm.h"
 #include "hardware/spi.h"
 #include "hardware/structs/bus_ctrl.h"
 #include "hardware/structs/ssi.h"
+#include "hardware/structs/systick.h"
 #include "hardware/sync.h"
 #include "hardware/vreg.h"
 #include "pico/binary_info.h"
@@ -13,37 +13,244 @@
  */
 
 #include "driver.h"
+#include "dvi/dvi.h"
 #include "global.h"
 #include "pet.h"
 #include "roms.h"
 
+// The ROM set is staged once in the upper 64 KB bank of SRAM, which the PET does not use.  Each
+// reset then restores it with the FPGA's copy engine rather than resending the images over SPI.
+#define PET_ROM_BANK    0x10000
+
+// Upload attempts per ROM segment before giving up.
+#define PET_ROM_ATTEMPTS    3
+
+// CRC-32 as computed by the FPGA's DMA engine (reflected polynomial $EDB88320, as zlib's 'crc32()').
+static uint32_t crc32(const uint8_t* pSrc, uint32_t byteLength) {
+    uint32_t crc = 0xffffffff;
+
+    while (byteLength--) {
+        crc ^= *pSrc++;
+        for (uint32_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+
+    return ~crc;
+}
+
+// Writes a ROM image to the upper bank at the same offset it occupies in the PET's address space.
+// $1E800-$1E8FF is the FPGA register page, so that part of the image is not staged.  (It is
+// shadowed by the I/O page in the PET's address space anyway.)
+//
+// Segments that already hold the image (e.g., after the MCU alone was reset) are not resent, and
+// each upload is verified by comparing the FPGA's CRC of the bank with the CRC of the flash copy.
+static void pet_stage_rom(uint32_t addr, const uint8_t* pSrc, uint32_t byteLength) {
+    for (uint32_t offset = 0; offset < byteLength;) {
+        const uint32_t dest = addr + offset;
+        uint32_t n = byteLength - offset;
+
+        if (dest < 0xe800 && dest + n > 0xe800) {
+            n = 0xe800 - dest;
+        } else if (dest >= 0xe800 && dest < 0xe900) {
+            offset += 0xe900 - dest;
+            continue;
+        }
+
+        const uint32_t crc = crc32(pSrc + offset, n);
+
+        for (uint32_t attempt = 0; spi_crc32(PET_ROM_BANK | dest, n) != crc; attempt++) {
+            if (attempt == PET_ROM_ATTEMPTS) {
+                printf("ROM $%04lx: CRC mismatch after %d uploads\n", dest, PET_ROM_ATTEMPTS);
+                break;
+            }
+
+            spi_write(/* dest: */ PET_ROM_BANK | dest, /* pSrc: */ pSrc + offset, n);
+        }
+
+        offset += n;
+    }
+}
+
 void pet_reset() {
+    static bool staged = false;
+
     set_cpu(/* reset: */ true, /* run: */ false);
     set_cpu(/* reset: */ false, /* run: */ false);
 
-    spi_write(/* dest: */ 0x8800, /* pSrc: */ rom_chars_8800,  sizeof(rom_chars_8800));
-    spi_write(/* dest: */ 0xb000, /* pSrc: */ rom_basic_b000,  sizeof(rom_basic_b000));
-    spi_write(/* dest: */ 0xc000, /* pSrc: */ rom_basic_c000,  sizeof(rom_basic_c000));
-    spi_write(/* dest: */ 0xd000, /* pSrc: */ rom_basic_d000,  sizeof(rom_basic_d000));
-    spi_write(/* dest: */ 0xe000, /* pSrc: */ rom_edit_e000,   sizeof(rom_edit_e000));
-    spi_write(/* dest: */ 0xf000, /* pSrc: */ rom_kernal_f000, sizeof(rom_kernal_f000));
+    if (!staged) {
+        pet_stage_rom(/* addr: */ 0x8800, /* pSrc: */ rom_chars_8800,  sizeof(rom_chars_8800));
+        pet_stage_rom(/* addr: */ 0xb000, /* pSrc: */ rom_basic_b000,  sizeof(rom_basic_b000));
+        pet_stage_rom(/* addr: */ 0xc000, /* pSrc: */ rom_basic_c000,  sizeof(rom_basic_c000));
+        pet_stage_rom(/* addr: */ 0xd000, /* pSrc: */ rom_basic_d000,  sizeof(rom_basic_d000));
+        pet_stage_rom(/* addr: */ 0xe000, /* pSrc: */ rom_edit_e000,   sizeof(rom_edit_e000));
+        pet_stage_rom(/* addr: */ 0xf000, /* pSrc: */ rom_kernal_f000, sizeof(rom_kernal_f000));
+        staged = true;
+    }
+
+    // Restore the character generator and $B000-$FFFF.  (The copy engine skips the I/O page.)
+    spi_copy(/* dest: */ 0x8800, /* src: */ PET_ROM_BANK | 0x8800, /* byteLength: */ 0x0800);
+    spi_copy(/* dest: */ 0xb000, /* src: */ PET_ROM_BANK | 0xb000, /* byteLength: */ 0x5000);
 
     // Reset and resume CPU
     set_cpu(/* reset: */ true, /* run: */ false);
     set_cpu(/* reset: */ false, /* run: */ true);
 }
 
+// Appends segments that read the dirty 32 byte chunks of PET RAM at 'addr' into 'pBuffer'.  Adjacent
+// dirty chunks are coalesced into a single segment.  Returns the number of segments appended.
+static uint32_t dirty_spans(const uint8_t* pDirty, uint32_t addr, uint8_t* pBuffer, uint32_t byteLength, spi_segment* pSpans) {
+    const uint32_t numChunks = (byteLength + FPGA_VRAM_DIRTY_CHUNK - 1) / FPGA_VRAM_DIRTY_CHUNK;
+    uint32_t numSpans = 0;
+    uint32_t chunk = 0;
+
+    while (chunk < numChunks) {
+        if (!(pDirty[chunk >> 3] & (1 << (chunk & 7)))) {
+            chunk++;
+            continue;
+        }
+
+        const uint32_t start = chunk * FPGA_VRAM_DIRTY_CHUNK;
+        while (chunk < numChunks && (pDirty[chunk >> 3] & (1 << (chunk & 7)))) {
+            chunk++;
+        }
+
+        uint32_t end = chunk * FPGA_VRAM_DIRTY_CHUNK;
+        if (end > byteLength) {
+            end = byteLength;
+        }
+
+        pSpans[numSpans++] = (spi_segment) {
+            /* rw_n: */ true, /* addr: */ addr + start, /* pData: */ pBuffer + start, /* byteLength: */ end - start
+        };
+    }
+
+    return numSpans;
+}
+
+// Dispatch TinyUSB events while a transfer runs in the background.
+static void pet_xfer_wait(const spi_xfer* pXfer) {
+    do {
+        tuh_task();
+    } while (!spi_xfer_done(pXfer));
+}
+
+uint32_t pet_frame_us() {
+    // Give the EDIT ROM time to program the CRTC after reset.
+    sleep_ms(100);
+
+    uint8_t crtc[VIDEO_CRTC_REG_COUNT];
+    spi_read(crtc, FPGA_REG_CRTC, sizeof(crtc));
+
+    // The CRTC character clock is 1 MHz.  A frame is (R0 + 1) characters per scan line, times
+    // (R4 + 1) rows of (R9 + 1) scan lines plus R5 adjustment lines.
+    return (crtc[0] + 1)
+        * (((crtc[4] & 0x7f) + 1) * ((crtc[9] & 0x1f) + 1) + (crtc[5] & 0x1f));
+}
+
+// Interval between status polls while waiting for the next PET frame, and the longest wait
+// before capturing anyway (e.g., while the CRTC is held in reset).
+#define PET_FRAME_POLL_US       500
+#define PET_FRAME_TIMEOUT_US    25000
+
 void pet_main() {
+    spi_xfer xfer;
+    uint8_t vram_dirty[16];                 // Display RAM (bytes 0-7) and character generator (bytes 8-15)
+    uint8_t crtc[VIDEO_CRTC_REG_COUNT];
+    uint8_t published_crtc[VIDEO_CRTC_REG_COUNT];
+
+    // The key matrix write and the dirty bitmap and CRTC register reads are exchanged as a single
+    // batch (one CS_N frame).  The graphics flag is returned in the status byte of every command.
+    const spi_segment poll[] = {
+        { /* rw_n: */ false, /* addr: */ 0xe800,              /* pData: */ key_matrix, /* byteLength: */ sizeof(key_matrix) },
+        { /* rw_n: */ true,  /* addr: */ FPGA_REG_VRAM_DIRTY, /* pData: */ vram_dirty, /* byteLength: */ sizeof(vram_dirty) },
+        { /* rw_n: */ true,  /* addr: */ FPGA_REG_CRTC,       /* pData: */ crtc,       /* byteLength: */ sizeof(crtc) },
+    };
+
+    // Worst case is every other chunk dirty.
+    spi_segment spans[(sizeof(vram_dirty) * 8 + 1) / 2];
+
+    // The bitmap may have been cleared by a previous run of the firmware, so the first pass
+    // reads the entire screen and character generator.
+    bool first = true;
+
+#ifdef PET_STATS
+    uint32_t stats_start_us = time_us_32();
+#endif
+
+    uint8_t frame = spi_status() & SPI_STATUS_FRAME;
+
     while (true) {
-        // Dispatch TinyUSB events
-        tuh_task();
+        // Capture once per PET frame, starting at the PET's vertical sync, so that each PET frame
+        // is published exactly once.  The key matrix is refreshed while waiting, and the FRAME
+        // bit of the returned status byte signals the start of the next frame.
+        const uint32_t wait_start_us = time_us_32();
+        do {
+            const uint32_t poll_start_us = time_us_32();
+            while (time_us_32() - poll_start_us < PET_FRAME_POLL_US) {
+                tuh_task();
+            }
+
+            spi_batch_async(&xfer, poll, /* numSegments: */ 1, /* pCallback: */ NULL);
+            pet_xfer_wait(&xfer);
+        } while ((spi_status() & SPI_STATUS_FRAME) == frame
+            && time_us_32() - wait_start_us < PET_FRAME_TIMEOUT_US);
+
+        frame = spi_status() & SPI_STATUS_FRAME;
+
+        spi_batch_async(&xfer, poll, count_of(poll), /* pCallback: */ NULL);
+        pet_xfer_wait(&xfer);
+
+        if (first) {
+            memset(vram_dirty, 0xff, sizeof(vram_dirty));
+            first = false;
+        }
+
+        // Read only the screen RAM and character generator that changed since the previous pass,
+        // then hand a consistent snapshot of the screen to the DVI core.
+        uint32_t numSpans = dirty_spans(
+            vram_dirty, /* addr: */ 0x8000, video_char_buffer, VIDEO_CHAR_BUFFER_BYTE_SIZE, spans);
+        numSpans += dirty_spans(
+            vram_dirty + 8, /* addr: */ 0x8800, video_font_buffer, VIDEO_FONT_BYTE_SIZE, spans + numSpans);
+
+        if (numSpans) {
+            spi_batch_async(&xfer, spans, numSpans, /* pCallback: */ NULL);
+            pet_xfer_wait(&xfer);
+        }
+
+        // Select the character set before publishing, so the first snapshot never renders
+        // through an unset font pointer.
+        p_video_font = spi_status() & SPI_STATUS_GFX ? video_font_buffer + 0x400 : video_font_buffer;
+
+        if (numSpans || memcmp(crtc, published_crtc, sizeof(crtc)) != 0) {
+            video_publish(video_char_buffer, crtc);
+            memcpy(published_crtc, crtc, sizeof(crtc));
+        }
+
+#ifdef PET_STATS
+        // Report link utilization and scanline render time about once per second.  Printing
+        // blocks for several milliseconds, so this is only enabled in diagnostic builds.
+        const uint32_t elapsed_us = time_us_32() - stats_start_us;
+        if (elapsed_us >= 1000000) {
+            spi_link_stats stats;
+            spi_link_stats_get(&stats);
+            spi_link_stats_reset();
+            stats_start_us += elapsed_us;
+
+            printf("spi: %lu frames, %lu cmds, %lu data + %lu overhead bytes, %lu%% busy\n",
+                stats.frames, stats.commands, stats.payloadBytes, stats.overheadBytes,
+                (uint32_t) ((uint64_t) stats.busyUs * 100 / elapsed_us));
 
-        spi_write(/* dest */ 0xe800, /* pSrc: */ key_matrix, /* byteLength: */ sizeof(key_matrix));
-        
-        spi_read_at(0xe80f);
-        uint8_t flags = spi_read_next();
-        p_video_font = flags & 0x01 ? p_video_font_400 : p_video_font_000;
+            video_render_stats render;
+            video_render_stats_get(&render);
+            video_render_stats_reset();
 
-        spi_read(/* pDest: */ video_char_buffer, /* src: */ 0x8000, /* byteLength: */ 1000);
+            printf("dvi: %lu lines (%lu%% reused), %lu avg / %lu max of %lu cycles per line (%ld margin), %lu us max latency\n",
+                render.lines, render.lines ? render.reusedLines * 100 / render.lines : 0,
+                render.lines ? render.cycles / render.lines : 0, render.maxCycles,
+                render.budgetCycles, (int32_t) (render.budgetCycles - render.maxCycles),
+                render.maxLatencyUs);
+        }
+#endif
     }
 }
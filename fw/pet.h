@@ -18,3 +18,6 @@
 
 void pet_reset();
 void pet_main();
+
+// Returns the PET's frame period (in microseconds), as programmed into the CRTC by the EDIT ROM.
+uint32_t pet_frame_us();
@@ -33,6 +33,10 @@ static const uint8_t __in_flash(".rom_basic_d000") rom_basic_d000[] = {
 };
 
 static const uint8_t __in_flash(".rom_edit_e000") rom_edit_e000[] = {
+#if PET_80_COL
+    // Edit 4.0, 80 column, Business Keyboard, 60 Hz, CRTC
+    #include "roms/edit-4-80-b-60Hz.901474-03.h"
+#else
     // Edit 4.0, 40 column, Graphics Keyboard, no CRTC
     // #include "roms/edit-4-n.901447-29.h"
 
@@ -41,9 +45,7 @@ static const uint8_t __in_flash(".rom_edit_e000") rom_edit_e000[] = {
 
     // Edit 4.0, 40 column, Graphics Keyboard, 50 Hz, CRTC
     #include "roms/edit-4-40-n-50Hz.901498-01.h"
-
-    // Edit 4.0, 80 column, Business Keyboard, 60 Hz, CRTC
-    // #include "roms/edit-4-80-b-60Hz.901474-03.h"
+#endif
 };
 
 static const uint8_t __in_flash(".rom_kernal_f000") rom_kernal_f000[] = {
@@ -3,4 +3,7 @@
 #include "../pch.h"
 #include "sd_card.h"
 
+// The SD card shares SCK, MOSI and MISO with the FPGA link, which drives them from PIO1 once
+// 'driver_init' has run.  Nothing hands the pins back to the hardware SPI, so the SD card is
+// unusable while the link owns the bus.
 void init_sd();
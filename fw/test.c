@@ -13,6 +13,7 @@
  */
 
 #include "driver.h"
+#include "dvi/dvi.h"
 #include "global.h"
 #include "roms.h"
 #include "test.h"
@@ -28,8 +29,21 @@ static const addr_range mem_test_addr_range[] = {
     { 0xE900, 0xFFFF }
 };
 
+// CRTC registers for the TEST build's 25 rows of 'VIDEO_CHAR_COLS' characters, starting at $8000.
+// (In 80 column mode, each CRTC address is 2 characters.)
+static const uint8_t test_crtc[VIDEO_CRTC_REG_COUNT] = {
+    [1]  = VIDEO_CHAR_COLS >> PET_80_COL,   // H Displayed
+    [6]  = VIDEO_CHAR_ROWS,                 // V Displayed
+    [9]  = 7,                               // Scan Lines - 1
+};
+
+// Shows 'video_char_buffer' on the DVI display.
+void publish_display() {
+    video_publish(video_char_buffer, test_crtc);
+}
+
 void sync_display() {
-    spi_write(/* dest: */ 0x8000, /* pSrc: */ video_char_buffer, /* byteLength: */ 1000);
+    spi_write(/* dest: */ 0x8000, /* pSrc: */ video_char_buffer, /* byteLength: */ VIDEO_CHAR_BUFFER_BYTE_SIZE);
 }
 
 void test_reset() {
@@ -43,7 +57,7 @@ void test_reset() {
 }
 
 uint8_t* xy(uint8_t x, uint8_t y) {
-    return y * 40 + x + video_char_buffer;
+    return y * VIDEO_CHAR_COLS + x + video_char_buffer;
 }
 
 void h_line(uint8_t start_x, uint8_t end_x, uint8_t y, uint8_t ch) {
@@ -67,7 +81,7 @@ void v_line(uint8_t x, uint8_t start_y, uint8_t end_y, uint8_t ch) {
 
     while (remaining--) {
         *pDest = ch;
-        pDest += 40;
+        pDest += VIDEO_CHAR_COLS;
     }
 }
 
@@ -75,6 +89,15 @@ void set(uint8_t x, uint8_t y, uint8_t ch) {
     *xy(x, y) = ch;
 }
 
+// Writes an ASCII string (upper case, digits and punctuation) as PET screen codes.
+void print_at(uint8_t x, uint8_t y, const char* pStr) {
+    uint8_t* pDest = xy(x, y);
+
+    while (*pStr) {
+        *pDest++ = *pStr++ & 0x3f;
+    }
+}
+
 void test_display() {
     p_video_font = p_video_font_000;
     memset(video_char_buffer, 0, sizeof(video_char_buffer));
@@ -91,91 +114,48 @@ void test_display() {
 
     while (true) {
         video_char_buffer[0]++;
+        publish_display();
+        sleep_ms(20);
     };
 }
 
-void check_byte(uint32_t addr, uint8_t actual, uint8_t expected) {
-    if (actual != expected) {
-        printf("$%x: Expected %d, but got %d\n", addr, expected, actual);
-        panic("");
-    }
-}
-
-uint8_t toggle_bit(uint32_t addr, uint8_t bit, uint8_t expected) {
-    spi_read_at(addr);
-    uint8_t byte = spi_read_next();
-    uint8_t actual = (byte >> bit) & 1;
-    
-    if (actual != expected) {
-        printf("$%x[%d]: Expected %d, but got %d (actual byte read %x)\n", addr, bit, expected, actual, byte);
-        panic("");
-    }
-
-    byte = byte ^ (1 << bit);
-    spi_write_at(addr, byte);
-    return byte;
-}
-
-typedef void march_element_fn(int32_t addr, int8_t bit);
-
-void r0w1(int32_t addr, int8_t bit) {
-    toggle_bit(addr, bit, /* expected: */ 0);
-}
-
-void r1w0(int32_t addr, int8_t bit) {
-    toggle_bit(addr, bit, /* expected: */ 1);
-}
-
-typedef void march_visit_fn(march_element_fn* pFn);
-
-void test_each_bit(int32_t start_addr, int32_t end_addr, march_element_fn* pFn) {
-    int8_t start_bit;
-    int32_t delta;
+// An element of a byte-wide March test, run by the FPGA's DMA engine.
+typedef struct {
+    const char* name;
+    bool value;                         // Expected bit value
+    bool descending;                    // Visit ranges and addresses in descending order
+    bool readOnly;                      // Verify only (otherwise invert each byte after verifying)
+} march_element;
+
+// March C-, following the initial ⇑(w0) (see 'test_ram').
+static const march_element march_c_minus[] = {
+    { /* name: */ "⇑(r0,w1)", /* value: */ false, /* descending: */ false, /* readOnly: */ false },
+    { /* name: */ "⇑(r1,w0)", /* value: */ true,  /* descending: */ false, /* readOnly: */ false },
+    { /* name: */ "⇓(r0,w1)", /* value: */ false, /* descending: */ true,  /* readOnly: */ false },
+    { /* name: */ "⇓(r1,w0)", /* value: */ true,  /* descending: */ true,  /* readOnly: */ false },
+    { /* name: */ "⇑(r0)",    /* value: */ false, /* descending: */ false, /* readOnly: */ true  },
+};
 
-    // Because start/end are inclusive we need to increment our bytes remaining count by one.
-    int32_t bytes_remaining = 1;
+void test_march_element(const march_element* pElement) {
+    const int32_t num_ranges = sizeof(mem_test_addr_range) / sizeof(addr_range);
 
-    if (start_addr < end_addr) {
-        bytes_remaining += end_addr - start_addr;
-        start_bit = 0;
-        delta = 1;
-    } else {
-        bytes_remaining += start_addr - end_addr;
-        start_bit = 7;
-        delta = -1;
-    }
+    printf("%s:\n", pElement->name);
 
-    printf("    $%04x-$%04x: ", start_addr, end_addr);
+    for (int32_t i = 0; i < num_ranges; i++) {
+        const addr_range range = mem_test_addr_range[pElement->descending ? num_ranges - 1 - i : i];
+        const uint32_t start_addr = pElement->descending ? range.max : range.min;
+        const uint32_t end_addr   = pElement->descending ? range.min : range.max;
 
-    int32_t addr = start_addr;
+        printf("    $%04lx-$%04lx: ", start_addr, end_addr);
 
-    for (; bytes_remaining; addr = addr + delta, bytes_remaining--) {
-        for (int8_t bit = start_bit, bits_remaining = 8; bits_remaining; bit = bit + delta, bits_remaining--) {
-            pFn(addr, bit);
+        spi_march_fault fault;
+        if (!spi_march(start_addr, range.max - range.min + 1, pElement->value, pElement->descending, pElement->readOnly, &fault)) {
+            printf("$%lx[%d]: Expected %d, but got %d (actual byte read %x)\n",
+                fault.addr, fault.bit, pElement->value, !pElement->value, fault.actual);
+            panic("");
         }
-    }
-
-    // Paranoid check that we ended up at the desired address.
-    assert(addr == end_addr + delta);
 
-    puts("OK");
-}
-
-void test_each_bit_ascending(march_element_fn* pFn) {
-    const size_t num_ranges = sizeof(mem_test_addr_range) / sizeof(addr_range);
-
-    for (size_t i = 0; i < num_ranges; i++) {
-        const addr_range range = mem_test_addr_range[i];
-        test_each_bit(/* start: */ range.min, /* end: */ range.max, pFn);
-    }
-}
-
-void test_each_bit_descending(march_element_fn* pFn) {
-    const int32_t num_ranges = sizeof(mem_test_addr_range) / sizeof(addr_range);
-    
-    for (int32_t i = num_ranges - 1; i >= 0; i--) {
-        const addr_range range = mem_test_addr_range[i];
-        test_each_bit(/* start: */ range.max, /* end: */ range.min, pFn);
+        puts("OK");
     }
 }
 
@@ -183,43 +163,38 @@ void test_ram() {
     set_cpu(/* reset: */ false, /* run: */ false);
     sleep_ms(1);
 
+    p_video_font = p_video_font_000;
+    memset(video_char_buffer, ' ', sizeof(video_char_buffer));
+    print_at(/* x: */ 0, /* y: */ 0, "RAM TEST (MARCH C-)");
+    publish_display();
+
     for (uint32_t iteration = 1;; iteration++) {
         puts("Suspending CPU");
 
         set_cpu(/* reset: */ false, /* run: */ false);
         sleep_ms(1);
 
-        uint32_t iteration = 0;
+        printf("\nRAM Test (March C-): Iteration #%lu:\n", iteration);
 
-        printf("\nRAM Test (March C-): Iteration #%d:\n", iteration++);
+        const uint64_t start_us = time_us_64();
 
         printf("⇑(w0):\n");
         const int32_t addr_min = 0x0000;
         const int32_t addr_max = 0xFFFF;
 
-        spi_write_at(addr_min, 0);
-        for (int32_t addr = addr_min + 1; addr <= addr_max; addr++) {
-            spi_write_next(0);
-        }
+        spi_fill(addr_min, /* value: */ 0, /* byteLength: */ addr_max - addr_min + 1);
         puts("OK");
 
-        printf("⇑(r0,w1):\n");
-        test_each_bit_ascending(r0w1);
-
-        printf("⇑(r1,w0):\n");
-        test_each_bit_ascending(r1w0);
+        for (uint32_t i = 0; i < sizeof(march_c_minus) / sizeof(march_element); i++) {
+            test_march_element(&march_c_minus[i]);
+        }
 
-        printf("⇓(r0,w1):\n");
-        test_each_bit_descending(r0w1);
-        
-        printf("⇓(r1,w0):\n");
-        test_each_bit_descending(r1w0);
+        const uint32_t elapsed_ms = (uint32_t) ((time_us_64() - start_us) / 1000);
+        printf("Completed in %lu ms\n", elapsed_ms);
 
-        printf("⇑(r0):\n");
-        spi_read_at(addr_min);
-        for (int32_t addr = addr_min; addr <= addr_max; addr++) {
-            check_byte(addr, spi_read_next(), 0);
-        }
-        puts("OK");
+        char status[VIDEO_CHAR_COLS + 1];
+        snprintf(status, sizeof(status), "ITERATION %lu OK (%lu MS)", iteration, elapsed_ms);
+        print_at(/* x: */ 0, /* y: */ 2, status);
+        publish_display();
     }
 }
@@ -35,6 +35,114 @@ module sim;
         driver.set_cpu(/* reset: */ 1, /* ready: */ 0);
         driver.set_cpu(/* reset: */ 0, /* ready: */ 1);
 
+        $display("[%t] SPI: Burst read", $time);
+        for (addr = 0; addr < 16; addr++) begin
+            driver.spi_write(17'h00400 + addr, 8'h40 + addr);
+        end
+        driver.expect_burst(/* addr: */ 17'h00400, /* length: */ 16, /* first_data: */ 8'h40);
+
+        $display("[%t] SPI: READ_AT / READ_NEXT", $time);
+        driver.expect_read_next(/* addr: */ 17'h00400, /* length: */ 16, /* first_data: */ 8'h40);
+        driver.expect_read_next_after_count(/* addr: */ 17'h00400, /* length: */ 1, /* first_data: */ 8'h40);
+        driver.expect_read_next_after_count(/* addr: */ 17'h00404, /* length: */ 8, /* first_data: */ 8'h44);
+
+        $display("[%t] SPI: Status byte", $time);
+        driver.expect_status(/* gfx: */ 1, /* cpu_res: */ 0, /* cpu_rdy: */ 1);
+        driver.expect_status(/* gfx: */ 0, /* cpu_res: */ 0, /* cpu_rdy: */ 1);
+
+        $display("[%t] SPI: Burst write", $time);
+        driver.spi_write_burst(/* addr: */ 17'h00500, /* length: */ 32, /* first_data: */ 8'h80);
+        driver.expect_burst(/* addr: */ 17'h00500, /* length: */ 32, /* first_data: */ 8'h80);
+
+        $display("[%t] SPI: Counted bursts in one frame", $time);
+        driver.expect_frame(/* addr: */ 17'h00600, /* length: */ 24, /* first_data: */ 8'h20);
+
+        $display("[%t] SPI: Read prefetch invalidated by CPU write", $time);
+        driver.spi_write_burst(/* addr: */ 17'h00300, /* length: */ 16, /* first_data: */ 8'h60);
+        driver.expect_burst(/* addr: */ 17'h00300, /* length: */ 4, /* first_data: */ 8'h60);
+        #2000;  // Prefetch $0305..
+
+        for (addr = 16'h0305; addr < 16'h030c; addr++) begin
+            driver.cpu_write(addr, 8'h90 + addr[7:0]);
+        end
+        #2000;
+
+        // Sequential with previous burst (served from prefetch buffer).
+        driver.expect_burst(/* addr: */ 17'h00305, /* length: */ 7, /* first_data: */ 8'h95);
+
+        $display("[%t] SPI: VRAM dirty bitmap", $time);
+        driver.expect_vram_dirty('1);                           // All dirty at power on
+        driver.expect_vram_dirty('0);                           // Cleared by read
+        driver.cpu_write(16'h8021, 8'h01);                      // Chunk 1
+        driver.cpu_write(16'h8400, 8'h02);                      // CPU mirrored to $8000: chunk 0
+        driver.spi_write(17'h08400, 8'h03);                     // SPI not mirrored: chunk 32
+        driver.spi_write(17'h08840, 8'h04);                     // Character generator: chunk 66
+        driver.expect_vram_dirty(128'h0000_0000_0000_0004_0000_0001_0000_0003);
+        driver.expect_vram_dirty('0);
+
+        $display("[%t] SPI: CRTC registers", $time);
+        driver.expect_crtc_reg(/* register: */ 5'd1,  /* expected: */ 8'd40);
+        driver.expect_crtc_reg(/* register: */ 5'd6,  /* expected: */ 8'd25);
+        driver.expect_crtc_reg(/* register: */ 5'd9,  /* expected: */ 8'd7);
+        driver.expect_crtc_reg(/* register: */ 5'd12, /* expected: */ 8'h10);
+
+        $display("[%t] CPU: Display RAM is 2KB in 80 column mode", $time);
+        driver.spi_write(17'h08000, 8'h11);
+        driver.spi_write(17'h08400, 8'h22);
+        driver.set_80_col(1);
+        driver.cpu_write(16'h8400, 8'h33);                      // Not mirrored to $8000
+        driver.cpu_write(16'h8c01, 8'h44);                      // Mirrored to $8401
+        driver.expect_burst(/* addr: */ 17'h08000, /* length: */ 1, /* first_data: */ 8'h11);
+        driver.expect_burst(/* addr: */ 17'h08400, /* length: */ 1, /* first_data: */ 8'h33);
+        driver.expect_burst(/* addr: */ 17'h08401, /* length: */ 1, /* first_data: */ 8'h44);
+        driver.set_80_col(0);
+        driver.cpu_write(16'h8400, 8'h55);                      // Mirrored to $8000
+        driver.expect_burst(/* addr: */ 17'h08000, /* length: */ 1, /* first_data: */ 8'h55);
+
+        $display("[%t] SPI: DMA engine", $time);
+        driver.spi_write_burst(/* addr: */ 17'h10a00, /* length: */ 48, /* first_data: */ 8'hc0);
+        driver.dma_copy(/* src: */ 17'h10a00, /* dst: */ 17'h00a00, /* length: */ 48);
+        driver.expect_burst(/* addr: */ 17'h00a00, /* length: */ 48, /* first_data: */ 8'hc0);
+        driver.expect_dma_compare(/* src: */ 17'h10a00, /* dst: */ 17'h00a00, /* length: */ 48, /* expected_dst: */ 'x);
+        driver.dma_fill(/* dst: */ 17'h00a10, /* fill: */ 8'h00, /* length: */ 4);
+        driver.expect_dma_compare(/* src: */ 17'h10a00, /* dst: */ 17'h00a00, /* length: */ 48, /* expected_dst: */ 17'h00a10);
+        driver.spi_write_burst(/* addr: */ 17'h00b00, /* length: */ 9, /* first_data: */ "1");
+        driver.expect_dma_crc(/* src: */ 17'h00b00, /* length: */ 9, /* expected: */ 32'hCBF43926);    // "123456789"
+
+        $display("[%t] SPI: DMA engine March C-", $time);
+        driver.dma_fill(/* dst: */ 17'h00c00, /* fill: */ 8'h00, /* length: */ 16);                    // ⇑(w0)
+        driver.expect_dma_march(17'h00c00, 16, /* value: */ 0, /* descending: */ 0, /* read_only: */ 0, 'x, 3'd0);  // ⇑(r0,w1)
+        driver.expect_dma_march(17'h00c00, 16, /* value: */ 1, /* descending: */ 0, /* read_only: */ 0, 'x, 3'd0);  // ⇑(r1,w0)
+        driver.expect_dma_march(17'h00c0f, 16, /* value: */ 0, /* descending: */ 1, /* read_only: */ 0, 'x, 3'd0);  // ⇓(r0,w1)
+        driver.expect_dma_march(17'h00c0f, 16, /* value: */ 1, /* descending: */ 1, /* read_only: */ 0, 'x, 3'd0);  // ⇓(r1,w0)
+        driver.expect_dma_march(17'h00c00, 16, /* value: */ 0, /* descending: */ 0, /* read_only: */ 1, 'x, 3'd0);  // ⇑(r0)
+        driver.spi_write(17'h00c05, 8'h08);
+        driver.expect_dma_march(17'h00c00, 16, /* value: */ 0, /* descending: */ 0, /* read_only: */ 1, 17'h00c05, 3'd3);
+        driver.spi_write(17'h00c0a, 8'h28);
+        driver.expect_dma_march(17'h00c00, 16, /* value: */ 0, /* descending: */ 0, /* read_only: */ 1, 17'h00c05, 3'd3);
+        driver.expect_dma_march(17'h00c0f, 16, /* value: */ 0, /* descending: */ 1, /* read_only: */ 1, 17'h00c0a, 3'd5);
+        driver.spi_write(17'h00c0a, 8'h00);
+        driver.expect_dma_march(17'h00c0f, 16, /* value: */ 0, /* descending: */ 1, /* read_only: */ 0, 17'h00c05, 3'd3);
+
+        $display("[%t] SPI: DMA engine uses CPU slots while CPU is halted", $time);
+        driver.dma_fill(/* dst: */ 17'h00e00, /* fill: */ 8'h00, /* length: */ 256);
+        driver.report_dma_march_rate(/* start: */ 17'h00e00, /* length: */ 256);
+        driver.set_cpu(/* reset: */ 0, /* ready: */ 0);
+        driver.report_dma_march_rate(/* start: */ 17'h00e00, /* length: */ 256);
+        driver.set_cpu(/* reset: */ 0, /* ready: */ 1);
+
+        $display("[%t] SPI: Read-modify-write", $time);
+        driver.spi_write(17'h00d00, 8'h5a);
+        driver.expect_rmw(/* op: */ 2'd2, 17'h00d00, /* mask: */ 8'h81, /* old: */ 8'h5a, /* new: */ 8'hdb);    // OR_AT
+        driver.expect_rmw(/* op: */ 2'd1, 17'h00d00, /* mask: */ 8'h0f, /* old: */ 8'hdb, /* new: */ 8'h0b);    // AND_AT
+        driver.expect_rmw(/* op: */ 2'd3, 17'h00d00, /* mask: */ 8'hff, /* old: */ 8'h0b, /* new: */ 8'hf4);    // XOR_AT
+
+        $display("[%t] SPI: Unused video slots reallocated to SPI", $time);
+        driver.report_slots();
+        driver.spi_write_burst(/* addr: */ 17'h00900, /* length: */ 64, /* first_data: */ 8'h00);
+        driver.expect_burst(/* addr: */ 17'h00900, /* length: */ 64, /* first_data: */ 8'h00);
+        driver.expect_video_slots();
+
         $display("[%t] SID: Play 440 Hz", $time);
         driver.cpu_write(16'h8f18, 8'h0F);      // Volume=15, No Filters
 
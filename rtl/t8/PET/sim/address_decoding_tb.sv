@@ -29,6 +29,7 @@ module address_decoding_tb();
     logic io_en;
     logic is_mirrored;
     logic is_readonly;
+    logic reg_en;
 
     address_decoding address_decoding(
         .addr_i(addr),
@@ -41,7 +42,8 @@ module address_decoding_tb();
         .sid_en_o(sid_en),
         .io_en_o(io_en),
         .is_mirrored_o(is_mirrored),
-        .is_readonly_o(is_readonly)
+        .is_readonly_o(is_readonly),
+        .reg_en_o(reg_en)
     );
 
     task check(
@@ -267,6 +269,26 @@ module address_decoding_tb();
             /* expected_is_readonly   : */ 1
         );
 
+        check_range(
+            /* name                   : */ "REG",
+            /* start_addr             : */ 'h1e800,
+            /* end_addr               : */ 'h1e8ff,
+            /* expected_ram_en        : */ 0,
+            /* expected_magic_en      : */ 0,
+            /* expected_pia1_en       : */ 0,
+            /* expected_pia2_en       : */ 0,
+            /* expected_via_en        : */ 0,
+            /* expected_crtc_en       : */ 0,
+            /* expected_sid_en        : */ 0,
+            /* expected_io_en         : */ 0,
+            /* expected_is_mirrored   : */ 0,
+            /* expected_is_readonly   : */ 0
+        );
+
+        for (addr = 'h1e800; addr <= 'h1e8ff; addr = addr + 1) begin
+            #1 `assert_equal(reg_en, 1);
+        end
+
         $display("[%t] Test Complete", $time);
         $finish;
     end
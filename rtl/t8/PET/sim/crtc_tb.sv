@@ -26,6 +26,7 @@ module sim;
         .clk16_i(clk16),
         .strobe_clk_o(strobe_clk),
         .setup_clk_o(setup_clk),
+        .cpu_halt_i('0),
         .cpu_en_o(cpu_en)
     );
     
@@ -41,6 +42,8 @@ module sim;
     logic        de;
     logic [13:0] ma;
     logic [4:0]  ra;
+    logic [4:0]  spi_ar = '0;
+    logic [7:0]  spi_r;
 
     crtc crtc(
         .reset_i(res),
@@ -57,7 +60,9 @@ module sim;
         .v_sync_o(v_sync),              // Vertical sync
         .de_o(de),                      // Display enable
         .ma_o(ma),                      // Refresh RAM address lines
-        .ra_o(ra)                       // Raster address lines
+        .ra_o(ra),                      // Raster address lines
+        .spi_ar_i(spi_ar),              // Register read by MCU via SPI
+        .spi_r_o(spi_r)                 // Value of register 'spi_ar'
     );
 
     crtc_driver driver(
@@ -110,6 +115,19 @@ module sim;
         //     8'h00       // Display L:    Display start address (low bits)
         // });
 
+        // Registers are visible to the MCU via the second read port.
+        spi_ar = 5'd1;
+        #1 assert(spi_r == 8'd3) else begin
+            $error("R1: Expected %d, but got %d.", 8'd3, spi_r);
+            $finish;
+        end
+
+        spi_ar = 5'd9;
+        #1 assert(spi_r == 8'h02) else begin
+            $error("R9: Expected %d, but got %d.", 8'h02, spi_r);
+            $finish;
+        end
+
         driver.reset();
 
         @(posedge h_sync);
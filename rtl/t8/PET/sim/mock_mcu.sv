@@ -32,6 +32,9 @@ module mock_mcu #(
         spi1.reset();
     endtask
 
+    // Status byte received during the most recent command byte.
+    logic [7:0] status;
+
     task send(
         logic unsigned [7:0] tx[]
     );
@@ -45,6 +48,7 @@ module mock_mcu #(
 
         $display("[%t]    send -> [%s]", $time, s);
         spi1.xfer_bytes(tx);
+        status = spi1.rx_first;
 
         // MCU continues asserting /CS until FPGA has finished processing the command,
         // indicated by the FPGA asserting READY.
@@ -53,8 +57,12 @@ module mock_mcu #(
         spi1.end_xfer();
     endtask
 
-    function [7:0] cmd(input bit rw_n, input bit set_addr, input logic [16:0] addr);
-        return { rw_n, set_addr, 5'bxxxxx, addr[16] };
+    function [7:0] cmd(input bit rw_n, input bit set_addr, input bit burst, input logic [16:0] addr, input bit count = '0);
+        // The 'C' bit is only meaningful for bursts.  Bits 3:1 select read-modify-write commands
+        // and must be zero otherwise.
+        return burst
+            ? { rw_n, set_addr, burst, count, 3'b000, addr[16] }
+            : { rw_n, set_addr, burst, 4'b0000, addr[16] };
     endfunction
 
     function [7:0] addr_hi(input logic [16:0] addr);
@@ -75,7 +83,7 @@ module mock_mcu #(
         logic [7:0] ah;
         logic [7:0] al;
 
-        c = cmd(/* rw_n: */ '0, /* set_addr: */ 1'b1, addr_i);
+        c = cmd(/* rw_n: */ '0, /* set_addr: */ 1'b1, /* burst: */ '0, addr_i);
         ah = addr_hi(addr_i);
         al = addr_lo(addr_i);
         last_addr = addr_i;
@@ -93,7 +101,7 @@ module mock_mcu #(
         logic [7:0] al;
         last_addr = addr_i;
 
-        c = cmd(/* rw_n: */ 1'b1, /* set_addr: */ 1'b1, addr_i);
+        c = cmd(/* rw_n: */ 1'b1, /* set_addr: */ 1'b1, /* burst: */ '0, addr_i);
         ah = addr_hi(addr_i);
         al = addr_lo(addr_i);
 
@@ -102,11 +110,165 @@ module mock_mcu #(
         //check(/* pending: */ 1'b1, /* rw_b: */ 1'b1, addr_i, /* data: */ 8'hxx);
     endtask
 
+    // Bytes received by the most recent 'read_burst()'.
+    logic [7:0] burst_data[256];
+
+    task read_burst(
+        input [16:0]  addr_i,
+        input integer length_i
+    );
+        logic [7:0] c;
+        logic [7:0] ah;
+        logic [7:0] al;
+        integer i;
+
+        c = cmd(/* rw_n: */ 1'b1, /* set_addr: */ 1'b1, /* burst: */ 1'b1, addr_i);
+        ah = addr_hi(addr_i);
+        al = addr_lo(addr_i);
+        last_addr = addr_i;
+
+        $display("[%t]    send -> [ %%%b %h %h ] + %0d bytes", $time, c, ah, al, length_i);
+        spi1.xfer_bytes('{ c, ah, al });
+        status = spi1.rx_first;
+
+        for (i = 0; i < length_i; i++) begin
+            // FPGA asserts READY when the next byte has been fetched.
+            wait (spi_ready_ni == '0);
+            spi1.xfer_next(8'hxx, burst_data[i]);
+        end
+
+        wait (spi_ready_ni == '0);
+        spi1.end_xfer();
+    endtask
+
+    task write_burst(
+        input [16:0]  addr_i,
+        input integer length_i,
+        input [7:0]   first_data_i
+    );
+        logic [7:0] c;
+        logic [7:0] ah;
+        logic [7:0] al;
+        logic [7:0] rx;
+        integer i;
+
+        c = cmd(/* rw_n: */ '0, /* set_addr: */ 1'b1, /* burst: */ 1'b1, addr_i);
+        ah = addr_hi(addr_i);
+        al = addr_lo(addr_i);
+        last_addr = addr_i;
+
+        $display("[%t]    send -> [ %%%b %h %h ] + %0d bytes", $time, c, ah, al, length_i);
+        spi1.xfer_bytes('{ c, ah, al });
+        status = spi1.rx_first;
+
+        for (i = 0; i < length_i; i++) begin
+            // FPGA asserts READY when it is ready to receive the next byte.
+            wait (spi_ready_ni == '0);
+            spi1.xfer_next(first_data_i + i, rx);
+        end
+
+        wait (spi_ready_ni == '0);
+        spi1.end_xfer();
+    endtask
+
+    // Counted bursts end in the DONE state, allowing multiple commands to be sent in a single
+    // CS_N frame.  Commands after the first wait for READY (DONE) before starting.
+    bit frame_pending = '0;
+
+    task begin_frame;
+        spi1.begin_xfer();
+        frame_pending = '0;
+    endtask
+
+    task frame_burst(
+        input bit     rw_n_i,
+        input [16:0]  addr_i,
+        input integer length_i,             // 1..256
+        input [7:0]   first_data_i          // (Ignored for reads)
+    );
+        logic [7:0] c;
+        logic [7:0] rx;
+        integer i;
+
+        c = cmd(rw_n_i, /* set_addr: */ 1'b1, /* burst: */ 1'b1, addr_i, /* count: */ 1'b1);
+        last_addr = addr_i;
+
+        if (frame_pending) wait (spi_ready_ni == '0);
+        frame_pending = 1'b1;
+
+        $display("[%t]    frame -> [ %%%b %h %h %h ] + %0d bytes", $time, c, addr_hi(addr_i), addr_lo(addr_i), length_i[7:0], length_i);
+        spi1.xfer_next(c, status);
+        spi1.xfer_next(addr_hi(addr_i), rx);
+        spi1.xfer_next(addr_lo(addr_i), rx);
+        spi1.xfer_next(length_i[7:0], rx);
+
+        for (i = 0; i < length_i; i++) begin
+            wait (spi_ready_ni == '0);
+            spi1.xfer_next(rw_n_i ? 8'hxx : first_data_i + i, burst_data[i]);
+        end
+    endtask
+
+    task end_frame;
+        wait (spi_ready_ni == '0);
+        spi1.end_xfer();
+    endtask
+
+    // READ_NEXT returns the data from the previous read in its data byte (after READY), then
+    // reads the next address.
+    task read_next(
+        output logic [7:0] data_o
+    );
+        logic [7:0] c;
+
+        c = cmd(/* rw_n: */ 1'b1, /* set_addr: */ '0, /* burst: */ '0, last_addr);
+        c[0] = '0;
+        last_addr = last_addr + 1'b1;
+
+        $display("[%t]    send -> [ %%%b ] + 1 byte", $time, c);
+        spi1.begin_xfer();
+        spi1.xfer_next(c, status);
+
+        wait (spi_ready_ni == '0);
+        spi1.xfer_next(8'hxx, data_o);
+
+        wait (spi_ready_ni == '0);
+        spi1.end_xfer();
+    endtask
+
+    // AND_AT, OR_AT, XOR_AT return the original byte in their data byte (after READY).
+    task rmw_at(
+        input  logic  [1:0] op,             // 1 = AND, 2 = OR, 3 = XOR
+        input  logic [16:0] addr_i,
+        input  logic  [7:0] mask_i,
+        output logic  [7:0] data_o
+    );
+        logic [7:0] c;
+        logic [7:0] unused;
+
+        c = cmd(/* rw_n: */ 1'b1, /* set_addr: */ 1'b1, /* burst: */ '0, addr_i);
+        c[2:1] = op;
+        last_addr = addr_i;
+
+        $display("[%t]    send -> [ %%%b %h %h %h ] + 1 byte", $time, c, mask_i, addr_hi(addr_i), addr_lo(addr_i));
+        spi1.begin_xfer();
+        spi1.xfer_next(c, status);
+        spi1.xfer_next(mask_i, unused);
+        spi1.xfer_next(addr_hi(addr_i), unused);
+        spi1.xfer_next(addr_lo(addr_i), unused);
+
+        wait (spi_ready_ni == '0);
+        spi1.xfer_next(8'hxx, data_o);
+
+        wait (spi_ready_ni == '0);
+        spi1.end_xfer();
+    endtask
+
     task set_cpu(
         input reset,
-        input ready
+        input ready,
+        input col_80
     );
-        write_at(17'he80f, { 6'h00, ready, !reset });
+        write_at(17'he80f, { 5'h00, col_80, ready, !reset });
     endtask
 
     always @(negedge spi1_cs_no) begin
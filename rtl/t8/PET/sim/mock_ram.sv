@@ -0,0 +1,33 @@
+/**
+ * PET Clone - Open hardware implementation of the Commodore PET
+ * by Daniel Lehenbauer and contributors.
+ * 
+ * https://github.com/DLehenbauer/commodore-pet-clone
+ *
+ * To the extent possible under law, I, Daniel Lehenbauer, have waived all
+ * copyright and related or neighboring rights to this project. This work is
+ * published from the United States.
+ *
+ * @copyright CC0 http://creativecommons.org/publicdomain/zero/1.0/
+ * @author Daniel Lehenbauer <DLehenbauer@users.noreply.github.com> and contributors
+ */
+
+module mock_ram(
+    input  logic [16:0]  ram_addr_i,
+    input  logic  [7:0]  ram_data_i,
+    output logic  [7:0]  ram_data_o,
+    output logic         ram_data_oe,
+    input  logic         ram_oe_ni,
+    input  logic         ram_we_ni
+);
+    logic [7:0] mem[17'h1ffff:0];
+
+    // RAM drives 'D[7:0]' when /OE is asserted.
+    assign ram_data_o  = mem[ram_addr_i];
+    assign ram_data_oe = !ram_oe_ni;
+
+    // Data is latched on the rising edge of /WE (end of write cycle).
+    always @(posedge ram_we_ni) begin
+        mem[ram_addr_i] <= ram_data_i;
+    end
+endmodule
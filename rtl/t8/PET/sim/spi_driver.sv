@@ -22,83 +22,75 @@ module spi_driver #(
     input  logic spi_rx_i,
     output logic spi_tx_o
 );
-    bit clk_sys = '0;
-
-    // Sampling clock for 'spi_byte_tx' must be 4x SCK_MHZ.
-    initial forever #(1000 / (SCK_MHZ * 4 * 2)) clk_sys = ~clk_sys;
-
-    bit start_sck = '0;
-
-    always @(posedge start_sck) begin
-        while (start_sck) begin
-            #(1000 / SCK_MHZ / 4);
-            spi_sck_o <= '1;
-            #(1000 / SCK_MHZ / 2);
-            spi_sck_o <= '0;
-            #(1000 / SCK_MHZ / 4);
-        end
-    end
+    // Half of the SCK period in ns.
+    localparam real SCK_HALF_NS = 1000.0 / SCK_MHZ / 2;
 
     task reset;
         spi_cs_no = '0;
-        @(posedge clk_sys);
+        #SCK_HALF_NS;
         spi_sck_o = '0;
         spi_cs_no = '1;
-        @(posedge clk_sys);
+        #SCK_HALF_NS;
     endtask
 
-    task begin_xfer(
-        input byte tx_i
-    );
+    task begin_xfer;
         assert(spi_cs_no == 1'b1) else begin
             $error("begin_xfer(): /CS must not be asserted.");
             $finish;
         end
 
-        // MSB of 'tx_byte' is preloaded while spi_cs_no is high on rising edge of clk_sys.
-        tx_byte = tx_i;
-        @(posedge clk_sys);
-
         spi_cs_no = '0;
-        #500;
-        start_sck = '1;
+        #SCK_HALF_NS;
     endtask
 
-    integer bit_index;
-
-    task xfer_bits(
-        input logic [7:0] next_tx = 8'hxx,
-        input integer num_bits = 8
+    // Mode 0 controller: Shifts out 'tx_i' on the falling edge of SCK and samples 'rx_o' on
+    // the rising edge.  SCK is left low after the last bit.
+    task xfer_byte(
+        input  logic [7:0] tx_i,
+        output logic [7:0] rx_o
     );
-        for (bit_index = 0; bit_index < num_bits; bit_index++) begin
-            @(posedge spi_sck_o);
+        integer i;
 
-            // 'tx_byte' is loaded on falling edge of spi_sck_o when the last bit is transfered.
-            // However, we update 'tx_byte' after every bit to verify that 'tx_byte' is held
-            // between loads.
-            tx_byte = next_tx;
+        for (i = 7; i >= 0; i--) begin
+            spi_tx_o = tx_i[i];
+            #SCK_HALF_NS;
+            spi_sck_o = 1'b1;
+            rx_o[i] = spi_rx_i;
+            #SCK_HALF_NS;
+            spi_sck_o = '0;
         end
     endtask
 
+    // Byte received during the first byte of the most recent 'xfer_bytes()'.
+    logic [7:0] rx_first;
+
     task xfer_bytes(
         input logic unsigned [7:0] tx[]
     );
-        integer i;
+        logic [7:0] rx;
         
-        // string s;
-        // s = "";
-        // foreach (tx[i]) s = { s, $sformatf("%h ", tx[i]) };
-        // $display("[%t] SPI Send: [ %s]", $time, s);
-
-        // 'tx_byte' is continuously preloaded from falling edge of CS_N.
-        begin_xfer(tx[0]);
+        begin_xfer();
 
+        // Bytes are transfered back-to-back without waiting for READY.
         foreach(tx[i]) begin
-            // 'next_tx' is the next byte to load on the 8th falling edge of SCK.
-            xfer_bits(tx[i + 1]);
+            xfer_byte(tx[i], rx);
+            if (i == 0) rx_first = rx;
         end
     endtask
 
+    // Transfers an additional byte while CS_N remains asserted (e.g., burst data).  Returns
+    // the byte received from the peripheral.
+    task xfer_next(
+        input  logic [7:0] tx_i,
+        output logic [7:0] rx_o
+    );
+        assert(spi_cs_no == '0) else begin
+            $error("xfer_next(): /CS must be asserted.");
+            $finish;
+        end
+
+        xfer_byte(tx_i, rx_o);
+    endtask
 
     task end_xfer(
         input bit next_cs_ni = 1'b1
@@ -108,24 +100,8 @@ module spi_driver #(
             $finish;
         end
 
-        start_sck = 0;
-
-        #500;
+        #SCK_HALF_NS;
         spi_cs_no = next_cs_ni;
-
-        #500;
+        #SCK_HALF_NS;
     endtask
-
-    logic       tx_valid;
-    logic [7:0] tx_byte = 8'hxx;
-
-    spi_byte spi_byte_tx(
-        .clk_sys_i(clk_sys),
-        .spi_sck_i(spi_sck_o),
-        .spi_cs_ni(spi_cs_no),
-        .spi_rx_i(spi_rx_i),
-        .spi_tx_o(spi_tx_o),
-        .tx_byte_i(tx_byte),
-        .valid_o(tx_valid)
-    );
 endmodule
@@ -0,0 +1,89 @@
+/**
+ * PET Clone - Open hardware implementation of the Commodore PET
+ * by Daniel Lehenbauer and contributors.
+ * 
+ * https://github.com/DLehenbauer/commodore-pet-clone
+ *
+ * To the extent possible under law, I, Daniel Lehenbauer, have waived all
+ * copyright and related or neighboring rights to this project. This work is
+ * published from the United States.
+ *
+ * @copyright CC0 http://creativecommons.org/publicdomain/zero/1.0/
+ * @author Daniel Lehenbauer <DLehenbauer@users.noreply.github.com> and contributors
+ */
+
+`timescale 1ns / 1ps
+
+// Exercises the SPI1 command protocol at a given SCK rate.
+module spi_rate_tb #(
+    parameter SPI1_MHZ = 4
+);
+    top_driver #(SPI1_MHZ) driver();
+
+    integer addr;
+    realtime start;
+
+    task run;
+        $display("[%t] SPI1 @ %0d MHz", $time, SPI1_MHZ);
+
+        driver.reset();
+
+        // WRITE_AT sends 4 bytes back-to-back without waiting for READY.
+        $display("[%t]   WRITE_AT / READ_BURST", $time);
+        for (addr = 0; addr < 16; addr++) begin
+            driver.spi_write(17'h00400 + addr, 8'h40 + addr + SPI1_MHZ);
+        end
+        driver.expect_burst(/* addr: */ 17'h00400, /* length: */ 16, /* first_data: */ 8'h40 + SPI1_MHZ);
+
+        $display("[%t]   WRITE_BURST / READ_BURST", $time);
+        driver.spi_write_burst(/* addr: */ 17'h00500, /* length: */ 64, /* first_data: */ 8'h80 + SPI1_MHZ);
+        driver.expect_burst(/* addr: */ 17'h00500, /* length: */ 64, /* first_data: */ 8'h80 + SPI1_MHZ);
+
+        // Writes are posted, so a burst that fits in the write FIFO is not limited to one byte
+        // per 1 us bus cycle.
+        $display("[%t]   Posted WRITE_BURST", $time);
+        start = $realtime;
+        driver.spi_write_burst(/* addr: */ 17'h00800, /* length: */ 16, /* first_data: */ 8'h30 + SPI1_MHZ);
+        if (SPI1_MHZ >= 20) begin
+            assert ($realtime - start < 16000) else begin
+                $error("Posted WRITE_BURST: Expected < 16 us, but took %0t.", $realtime - start);
+                $finish;
+            end
+        end
+        driver.expect_burst(/* addr: */ 17'h00800, /* length: */ 16, /* first_data: */ 8'h30 + SPI1_MHZ);
+
+        // Upper 64KB bank (A16).
+        driver.spi_write_burst(/* addr: */ 17'h1f000, /* length: */ 16, /* first_data: */ 8'hc0);
+        driver.expect_burst(/* addr: */ 17'h1f000, /* length: */ 16, /* first_data: */ 8'hc0);
+
+        $display("[%t]   WRITE_COUNT / READ_COUNT in one frame", $time);
+        driver.expect_frame(/* addr: */ 17'h00600, /* length: */ 100, /* first_data: */ 8'h10 + SPI1_MHZ);
+        driver.expect_frame(/* addr: */ 17'h00700, /* length: */ 1, /* first_data: */ 8'h55);
+
+        // Verify CPU control register is written correctly at this rate.
+        driver.set_cpu(/* reset: */ 1, /* ready: */ 0);
+        driver.set_cpu(/* reset: */ 0, /* ready: */ 1);
+    endtask
+endmodule
+
+// Verifies that the SCK-clocked SPI receiver operates correctly at link rates well above the
+// 16 MHz 'clk_sys' (i.e., rates the previous oversampling receiver could not support).
+module spi_tb;
+    spi_rate_tb #(4)  spi4();
+    spi_rate_tb #(16) spi16();
+    spi_rate_tb #(20) spi20();
+    spi_rate_tb #(25) spi25();
+
+    initial begin
+        $dumpfile("work_sim/out.vcd");
+        $dumpvars(0, spi_tb);
+
+        spi4.run();
+        spi16.run();
+        spi20.run();
+        spi25.run();
+
+        $display("[%t] Test Complete", $time);
+        $finish;
+    end
+endmodule
@@ -25,7 +25,8 @@ module top_driver #(
     logic  [7:0]  bus_data_i;
     logic  [7:0]  bus_data_o;
     logic  [7:0]  bus_data_7_0_oe;
-    logic [11:10] ram_addr_o;
+    logic [11:10] ram_addr_11_10_o;
+    logic [16:15] ram_addr_16_15_o;
     
     logic         spi1_sck;
     logic         spi1_cs_n;
@@ -48,7 +49,6 @@ module top_driver #(
     logic         cpu_nmi_no;
     logic         cpu_nmi_noe;
     logic         cpu_be_o;
-    logic         ram_ce_no;
     logic         pia1_cs2_no;
     logic         pia2_cs2_no;
     logic         via_cs2_no;
@@ -56,7 +56,7 @@ module top_driver #(
     logic         diag_i;
     logic         via_cb2_i;
     logic         audio_o;
-    logic         gfx_i;
+    logic         gfx_i = '0;
     logic         h_sync;
     logic         v_sync;
     logic         video;
@@ -72,11 +72,11 @@ module top_driver #(
         .bus_addr_15_0_i(bus_addr_i),
         .bus_addr_15_0_o(bus_addr_o[15:0]),
         .bus_addr_15_0_oe(bus_addr_15_0_oe),
-        .bus_addr_16_o(bus_addr_o[16]),
         .bus_data_7_0_i(bus_data_i),
         .bus_data_7_0_o(bus_data_o),
         .bus_data_7_0_oe(bus_data_7_0_oe),
-        .ram_addr_o(ram_addr_o),
+        .ram_addr_11_10_o(ram_addr_11_10_o),
+        .ram_addr_16_15_o(ram_addr_16_15_o),
         
         // SPI1
         .spi1_sck_i(spi1_sck),
@@ -100,7 +100,6 @@ module top_driver #(
         .cpu_nmi_no(cpu_nmi_no),
         .cpu_nmi_noe(cpu_nmi_noe),
         .cpu_be_o(cpu_be_o),
-        .ram_ce_no(ram_ce_no),
         .pia1_cs2_no(pia1_cs2_no),
         .pia2_cs2_no(pia2_cs2_no),
         .via_cs2_no(via_cs2_no),
@@ -202,12 +201,29 @@ module top_driver #(
                 ? bus_addr_o[15:0]
                 : 16'hxxxx;
 
+    logic [7:0] ram_data_o;
+    logic       ram_data_oe;
+
     assign bus_data_i =
         cpu_data_oe
             ? cpu_data_o
             : bus_data_7_0_oe
                 ? bus_data_o
-                : 8'hxx;
+                : ram_data_oe
+                    ? ram_data_o
+                    : 8'hxx;
+
+    // The 17th address bit is only driven by the FPGA.
+    assign bus_addr_o[16] = ram_addr_16_15_o[16];
+
+    mock_ram ram(
+        .ram_addr_i({ bus_addr_o[16], bus_addr_i[15:12], ram_addr_11_10_o, bus_addr_i[9:0] }),
+        .ram_data_i(bus_data_i),
+        .ram_data_o(ram_data_o),
+        .ram_data_oe(ram_data_oe),
+        .ram_oe_ni(ram_oe_no),
+        .ram_we_ni(ram_we_no)
+    );
 
     // The FPGA and CPU should never attempt to drive the bus signals simultaneously.
     always begin
@@ -227,6 +243,11 @@ module top_driver #(
             $error("FPGA and CPU must not both drive 'bus_data' simultaneously.");
             $finish;
         end
+
+        assert((ram_data_oe !== 1'b1) || (!cpu_data_oe && !bus_data_7_0_oe)) else begin
+            $error("RAM must not drive 'bus_data' while CPU or FPGA is driving 'bus_data'.");
+            $finish;
+        end
     end
 
     mock_mcu #(SPI1_MHZ) mcu(
@@ -250,6 +271,46 @@ module top_driver #(
         mcu.reset();
     endtask
 
+    // Count SPI bus transactions by the slot they were granted, to observe slot allocation.
+    integer spi_slot_count[8];
+    integer slot;
+
+    initial begin
+        for (slot = 0; slot < 8; slot++) spi_slot_count[slot] = 0;
+    end
+
+    always @(posedge top.main.timing.setup_clk_o) begin
+        if (top.main.timing.spi_en_o) begin
+            for (integer i = 0; i < 8; i++) begin
+                if (top.main.timing.en_q[i]) spi_slot_count[i]++;
+            end
+        end
+    end
+
+    task report_slots;
+        $display("[%t]    SPI slots: 0=%0d 1=%0d 2=%0d 3=%0d 4=%0d 5=%0d 6=%0d 7=%0d", $time,
+            spi_slot_count[0], spi_slot_count[1], spi_slot_count[2], spi_slot_count[3],
+            spi_slot_count[4], spi_slot_count[5], spi_slot_count[6], spi_slot_count[7]);
+
+        for (slot = 0; slot < 8; slot++) spi_slot_count[slot] = 0;
+    endtask
+
+    // Verifies that SPI was granted video slots since the last 'report_slots()', and never the
+    // video character fetch (slot 1) or CPU slots (6, 7).
+    task expect_video_slots;
+        assert(spi_slot_count[2] + spi_slot_count[3] + spi_slot_count[4] > 0) else begin
+            $error("Expected SPI to be granted unused video slots.");
+            $finish;
+        end
+
+        assert(spi_slot_count[1] + spi_slot_count[6] + spi_slot_count[7] == 0) else begin
+            $error("SPI must not be granted slots 1, 6, or 7.");
+            $finish;
+        end
+
+        report_slots();
+    endtask
+
     task ext_reset;
         @(posedge cpu_clk_o);
         cpu_res_ni = '0;
@@ -275,15 +336,36 @@ module top_driver #(
         end
     endtask
 
+    logic col_80 = '0;     // 80 column mode selected by 'set_80_col'
+
     task set_cpu(
         input reset,
         input ready
     );
-        mcu.set_cpu(reset, ready);
+        mcu.set_cpu(reset, ready, col_80);
+
+        // Writes are posted.  Reading back waits for the write to reach the bus.
+        mcu.read_at(17'he80f);
+
         expect_reset(reset);
         expect_ready(ready);
     endtask
 
+    task set_80_col(
+        input enable
+    );
+        col_80 = enable;
+        mcu.set_cpu(/* reset: */ !cpu_res_no, /* ready: */ cpu_ready_o, col_80);
+
+        // Writes are posted.  Reading back waits for the write to reach the bus.
+        mcu.read_at(17'he80f);
+
+        assert(top.main.video_80_col == enable) else begin
+            $error("video_80_col: Expected '%d', but got '%d'.", enable, top.main.video_80_col);
+            $finish;
+        end
+    endtask
+
     task wait_for_hsync();
         @(posedge h_sync);
     endtask
@@ -292,6 +374,331 @@ module top_driver #(
         @(posedge v_sync);
     endtask
 
+    task spi_write(
+        input logic [16:0] addr,
+        input logic  [7:0] data
+    );
+        mcu.write_at(addr, data);
+    endtask
+
+    task spi_write_burst(
+        input logic [16:0] addr,
+        input integer      length,
+        input logic  [7:0] first_data
+    );
+        mcu.write_burst(addr, length, first_data);
+    endtask
+
+    task expect_burst(
+        input logic [16:0] addr,
+        input integer      length,
+        input logic  [7:0] first_data
+    );
+        integer i;
+
+        mcu.read_burst(addr, length);
+
+        for (i = 0; i < length; i++) begin
+            assert(mcu.burst_data[i] == first_data + i) else begin
+                $error("read_burst($%x): Expected $%x, but got $%x.", addr + i, first_data + i, mcu.burst_data[i]);
+                $finish;
+            end
+        end
+    endtask
+
+    // Writes two counted bursts and reads them back with a single counted burst, all within
+    // one CS_N frame.
+    task expect_frame(
+        input logic [16:0] addr,
+        input integer      length,          // 1..128
+        input logic  [7:0] first_data
+    );
+        integer i;
+
+        mcu.begin_frame();
+        mcu.frame_burst(/* rw_n: */ '0, addr, length, first_data);
+        mcu.frame_burst(/* rw_n: */ '0, addr + length, length, first_data + length);
+        mcu.frame_burst(/* rw_n: */ 1'b1, addr, length * 2, 8'hxx);
+        mcu.end_frame();
+
+        for (i = 0; i < length * 2; i++) begin
+            assert(mcu.burst_data[i] == first_data + i) else begin
+                $error("frame($%x): Expected $%x, but got $%x.", addr + i, first_data + i, mcu.burst_data[i]);
+                $finish;
+            end
+        end
+    endtask
+
+    // Verifies the status byte returned during the command byte of the next command.
+    task expect_status(
+        input logic gfx,
+        input logic cpu_res,
+        input logic cpu_rdy
+    );
+        gfx_i = gfx;
+        mcu.read_at(17'h00000);
+
+        assert(mcu.status[0] == gfx && mcu.status[3] == cpu_res && mcu.status[4] == cpu_rdy && mcu.status[7:5] == '0) else begin
+            $error("status: Expected gfx=%d, cpu_res=%d, cpu_rdy=%d, but got %%%b.", gfx, cpu_res, cpu_rdy, mcu.status);
+            $finish;
+        end
+    endtask
+
+    // Verifies READ_AT followed by READ_NEXT returns sequential bytes.
+    task expect_read_next(
+        input logic [16:0] addr,
+        input integer      length,
+        input logic  [7:0] first_data
+    );
+        integer i;
+        logic [7:0] data;
+
+        mcu.read_at(addr);
+
+        for (i = 0; i < length; i++) begin
+            mcu.read_next(data);
+            assert(data == first_data + i) else begin
+                $error("read_next($%x): Expected $%x, but got $%x.", addr + i, first_data + i, data);
+                $finish;
+            end
+        end
+    endtask
+
+    // Verifies READ_NEXT after a counted burst returns the byte following the burst (rather than
+    // repeating the last byte of the burst).
+    task expect_read_next_after_count(
+        input logic [16:0] addr,
+        input integer      length,
+        input logic  [7:0] first_data
+    );
+        logic [7:0] data;
+
+        mcu.begin_frame();
+        mcu.frame_burst(/* rw_n: */ 1'b1, addr, length, 8'hxx);
+        mcu.end_frame();
+
+        mcu.read_next(data);
+        assert(data == first_data + length) else begin
+            $error("read_next($%x): Expected $%x, but got $%x.", addr + length, first_data + length, data);
+            $finish;
+        end
+    endtask
+
+    // Reads (and thereby clears) the VRAM dirty bitmap in the SPI register page.
+    task expect_vram_dirty(
+        input logic [127:0] expected
+    );
+        integer i;
+
+        mcu.read_burst(17'h1e800, 16);
+
+        for (i = 0; i < 16; i++) begin
+            assert(mcu.burst_data[i] == expected[i*8 +: 8]) else begin
+                $error("vram_dirty[%0d]: Expected %%%b, but got %%%b.", i, expected[i*8 +: 8], mcu.burst_data[i]);
+                $finish;
+            end
+        end
+    endtask
+
+    // Verifies the CRTC registers read via the SPI register page.
+    task expect_crtc_reg(
+        input logic [4:0] register,
+        input logic [7:0] expected
+    );
+        mcu.read_burst(17'h1e820 + register, 1);
+
+        assert(mcu.burst_data[0] == expected) else begin
+            $error("crtc[R%0d]: Expected $%x, but got $%x.", register, expected, mcu.burst_data[0]);
+            $finish;
+        end
+    endtask
+
+    // Starts a DMA engine operation and waits for it to complete.  Returns the STATUS register.
+    task dma_run(
+        input  logic  [2:0] op,             // 0 = COPY, 1 = FILL, 2 = COMPARE, 3 = CRC, 4 = MARCH
+        input  logic [16:0] src,
+        input  logic [16:0] dst,
+        input  logic  [7:0] fill,
+        input  logic [15:0] length,
+        output logic  [7:0] status
+    );
+        mcu.write_at(17'h1e850, src[7:0]);
+        mcu.write_at(17'h1e851, src[15:8]);
+        mcu.write_at(17'h1e852, { 7'h0, src[16] });
+        mcu.write_at(17'h1e853, dst[7:0]);
+        mcu.write_at(17'h1e854, dst[15:8]);
+        mcu.write_at(17'h1e855, { 7'h0, dst[16] });
+        mcu.write_at(17'h1e856, fill);
+        mcu.write_at(17'h1e857, { 5'h0, op });
+        mcu.write_at(17'h1e858, length[7:0]);
+        mcu.write_at(17'h1e859, length[15:8]);     // Starts operation
+
+        do begin
+            mcu.read_burst(17'h1e85a, 1);
+        end while (mcu.burst_data[0][0]);
+
+        status = mcu.burst_data[0];
+    endtask
+
+    task dma_copy(
+        input logic [16:0] src,
+        input logic [16:0] dst,
+        input logic [15:0] length
+    );
+        logic [7:0] status;
+        dma_run(/* op: */ 3'd0, src, dst, /* fill: */ 8'h00, length, status);
+    endtask
+
+    task dma_fill(
+        input logic [16:0] dst,
+        input logic  [7:0] fill,
+        input logic [15:0] length
+    );
+        logic [7:0] status;
+        dma_run(/* op: */ 3'd1, /* src: */ 17'h00000, dst, fill, length, status);
+    endtask
+
+    // Compares two ranges and verifies the address of the first mismatch (or none, if
+    // 'expected_dst' is 'x).
+    task expect_dma_compare(
+        input logic [16:0] src,
+        input logic [16:0] dst,
+        input logic [15:0] length,
+        input logic [16:0] expected_dst
+    );
+        logic [7:0] status;
+        logic [16:0] actual_dst;
+
+        dma_run(/* op: */ 3'd2, src, dst, /* fill: */ 8'h00, length, status);
+
+        if (expected_dst === 'x) begin
+            assert(!status[1]) else begin
+                $error("dma_compare($%x, $%x): Expected no mismatch.", src, dst);
+                $finish;
+            end
+        end else begin
+            mcu.read_burst(17'h1e853, 3);
+            actual_dst = { mcu.burst_data[2][0], mcu.burst_data[1], mcu.burst_data[0] };
+
+            assert(status[1] && actual_dst == expected_dst) else begin
+                $error("dma_compare($%x, $%x): Expected mismatch at $%x, but got status=%%%b, dst=$%x.", src, dst, expected_dst, status, actual_dst);
+                $finish;
+            end
+        end
+    endtask
+
+    // Hashes a range with the DMA engine and verifies the CRC-32.
+    task expect_dma_crc(
+        input logic [16:0] src,
+        input logic [15:0] length,
+        input logic [31:0] expected
+    );
+        logic  [7:0] status;
+        logic [31:0] actual;
+
+        dma_run(/* op: */ 3'd3, src, /* dst: */ 17'h00000, /* fill: */ 8'h00, length, status);
+        mcu.read_burst(17'h1e85b, 4);
+        actual = { mcu.burst_data[3], mcu.burst_data[2], mcu.burst_data[1], mcu.burst_data[0] };
+
+        assert(actual == expected) else begin
+            $error("dma_crc($%x, %0d): Expected $%x, but got $%x.", src, length, expected, actual);
+            $finish;
+        end
+    endtask
+
+    // Runs one March element with the DMA engine and verifies the first failure (or none, if
+    // 'expected_addr' is 'x).
+    task expect_dma_march(
+        input logic [16:0] start,           // First address visited (highest address if descending)
+        input logic [15:0] length,
+        input logic        value,           // Expected bit value ('r0' or 'r1')
+        input logic        descending,
+        input logic        read_only,
+        input logic [16:0] expected_addr,
+        input logic  [2:0] expected_bit
+    );
+        logic  [7:0] status;
+        logic [16:0] actual_addr;
+
+        dma_run(/* op: */ 3'd4, /* src: */ 17'h00000, /* dst: */ start, /* fill: */ { 5'h0, read_only, descending, value }, length, status);
+
+        if (expected_addr === 'x) begin
+            assert(!status[1]) else begin
+                $error("dma_march($%x): Expected no failure, but got status=%%%b.", start, status);
+                $finish;
+            end
+        end else begin
+            mcu.read_burst(17'h1e853, 3);
+            actual_addr = { mcu.burst_data[2][0], mcu.burst_data[1], mcu.burst_data[0] };
+
+            assert(status[1] && actual_addr == expected_addr && status[6:4] == expected_bit) else begin
+                $error("dma_march($%x): Expected failure at $%x[%0d], but got status=%%%b, addr=$%x.", start, expected_addr, expected_bit, status, actual_addr);
+                $finish;
+            end
+        end
+    endtask
+
+    // Reports the bus time per byte of MARCH elements over 'length' bytes at 'start' (which must
+    // hold zeros) and verifies that the CPU's slots 6 and 7 are given to the DMA engine only
+    // while the CPU is halted, and never to the MCU's own SPI transactions.
+    task report_dma_march_rate(
+        input logic [16:0] start,
+        input logic [15:0] length
+    );
+        realtime    start_time;
+        logic [7:0] status;
+
+        for (slot = 0; slot < 8; slot++) spi_slot_count[slot] = 0;
+        start_time = $realtime;
+
+        dma_run(/* op: */ 3'd4, /* src: */ 17'h00000, /* dst: */ start, /* fill: */ 8'h00, length, status);    // ⇑(r0,w1)
+        dma_run(/* op: */ 3'd4, /* src: */ 17'h00000, /* dst: */ start, /* fill: */ 8'h01, length, status);    // ⇑(r1,w0)
+
+        $display("[%t]    MARCH (CPU %s): %0.1f us per byte per element, SPI slots 6+7=%0d", $time,
+            cpu_ready_o ? "running" : "halted", ($realtime - start_time) / (2 * length) / 1000,
+            spi_slot_count[6] + spi_slot_count[7]);
+
+        assert(!status[1]) else begin
+            $error("dma_march($%x): Expected no failure, but got status=%%%b.", start, status);
+            $finish;
+        end
+
+        assert((spi_slot_count[6] + spi_slot_count[7] > 0) == !cpu_ready_o) else begin
+            $error("SPI must be granted slots 6 and 7 if and only if the CPU is halted.");
+            $finish;
+        end
+
+        for (slot = 0; slot < 8; slot++) spi_slot_count[slot] = 0;
+
+        mcu.read_burst(start, 64);
+        assert(spi_slot_count[6] + spi_slot_count[7] == 0) else begin
+            $error("SPI must not be granted slots 6 and 7 while the DMA engine is idle.");
+            $finish;
+        end
+
+        for (slot = 0; slot < 8; slot++) spi_slot_count[slot] = 0;
+    endtask
+
+    // Performs a read-modify-write command and verifies the original and resulting bytes.
+    task expect_rmw(
+        input logic  [1:0] op,              // 1 = AND, 2 = OR, 3 = XOR
+        input logic [16:0] addr,
+        input logic  [7:0] mask,
+        input logic  [7:0] expected_old,
+        input logic  [7:0] expected_new
+    );
+        logic [7:0] old;
+
+        mcu.rmw_at(op, addr, mask, old);
+
+        assert(old == expected_old) else begin
+            $error("rmw_at($%x): Expected original byte $%x, but got $%x.", addr, expected_old, old);
+            $finish;
+        end
+
+        expect_burst(addr, /* length: */ 1, /* first_data: */ expected_new);
+    endtask
+
     task cpu_write(
         input logic [15:0] addr,
         input logic [7:0]  data
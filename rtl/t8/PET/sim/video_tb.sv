@@ -28,6 +28,11 @@ module sim;
         .clk16_i(clk16),
         .strobe_clk_o(strobe_clk),
         .setup_clk_o(setup_clk),
+        .spi_valid_i('0),
+        .spi_atomic_i('0),
+        .video_blank_i('0),
+        .video_80_col_i('0),
+        .cpu_halt_i('0),
         .cpu_en_o(cpu_en),
         .vram0_en_o(vram0_en),
         .vrom0_en_o(vrom0_en)
@@ -75,6 +80,7 @@ module sim;
         .vram0_en_i(vram0_en),
         .vrom0_en_i(vrom0_en),
         .crtc_en_i(cs),
+        .col_80_mode_i('0),
         .rw_ni(rw_n),
         .addr_i(rs),
         .addr_o(addr_o),
@@ -24,9 +24,10 @@ module address_decoding(
     output logic crtc_en_o,
     output logic io_en_o,
     output logic is_mirrored_o,
-    output logic is_readonly_o
+    output logic is_readonly_o,
+    output logic reg_en_o
 );
-    localparam NUM_BITS         = 10;
+    localparam NUM_BITS         = 11;
 
     localparam RAM_EN_BIT       = 0,
                SID_EN_BIT       = 1,
@@ -37,7 +38,8 @@ module address_decoding(
                CRTC_EN_BIT      = 6,
                IO_EN_BIT        = 7,
                RAM_READONLY_BIT = 8,
-               RAM_MIRRORED_BIT = 9;
+               RAM_MIRRORED_BIT = 9,
+               REG_EN_BIT       = 10;
 
     localparam RAM_EN_MASK       = NUM_BITS'(1'b1) << RAM_EN_BIT,
                SID_EN_MASK       = NUM_BITS'(1'b1) << SID_EN_BIT,
@@ -48,7 +50,8 @@ module address_decoding(
                CRTC_EN_MASK      = NUM_BITS'(1'b1) << CRTC_EN_BIT,
                IO_EN_MASK        = NUM_BITS'(1'b1) << IO_EN_BIT,
                RAM_READONLY_MASK = NUM_BITS'(1'b1) << RAM_READONLY_BIT,
-               RAM_MIRRORED_MASK = NUM_BITS'(1'b1) << RAM_MIRRORED_BIT;
+               RAM_MIRRORED_MASK = NUM_BITS'(1'b1) << RAM_MIRRORED_BIT,
+               REG_EN_MASK       = NUM_BITS'(1'b1) << REG_EN_BIT;
 
     localparam RAM   = RAM_EN_MASK,
                VRAM  = RAM_EN_MASK  | RAM_MIRRORED_MASK,
@@ -58,7 +61,8 @@ module address_decoding(
                PIA1  = PIA1_EN_MASK | IO_EN_MASK,
                PIA2  = PIA2_EN_MASK | IO_EN_MASK,
                VIA   = VIA_EN_MASK  | IO_EN_MASK,
-               CRTC  = CRTC_EN_MASK;                    // No IO_EN: CRTC implemented on FPGA
+               CRTC  = CRTC_EN_MASK,                    // No IO_EN: CRTC implemented on FPGA
+               REG   = REG_EN_MASK;                     // Only reachable by SPI (CPU does not drive A16)
 
     logic [NUM_BITS-1:0] select = NUM_BITS'('hxxx);
 
@@ -72,6 +76,7 @@ module address_decoding(
             17'b0_1110_1000_001?_????: select = PIA2;   // PIA2  : E820-E83F
             17'b0_1110_1000_01??_????: select = VIA;    // VIA   : E840-E87F
             17'b0_1110_1000_1???_????: select = CRTC;   // CRTC  : E880-E8FF
+            17'b1_1110_1000_????_????: select = REG;    // REG   : 1E800-1E8FF (see 'spi_regs')
             default:                   select = ROM;    // ROM   : 9000-E800, E900-FFFF
         endcase
     end
@@ -87,4 +92,5 @@ module address_decoding(
     assign pia2_en_o      = select[PIA2_EN_BIT];
     assign via_en_o       = select[VIA_EN_BIT];
     assign crtc_en_o      = select[CRTC_EN_BIT];
+    assign reg_en_o       = select[REG_EN_BIT];
 endmodule
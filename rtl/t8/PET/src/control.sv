@@ -18,19 +18,22 @@ module control(
     input  logic  [7:0] spi_data_i,
     input  logic        spi_wr_en_i,
     output logic        cpu_res_o,
-    output logic        cpu_ready_o
+    output logic        cpu_ready_o,
+    output logic        col_80_o        // 80 column mode (selected by MCU to match the EDIT ROM)
 );
-    localparam RES_N = 0,
-               READY = 1;
+    localparam RES_N  = 0,
+               READY  = 1,
+               COL_80 = 2;
 
-    logic [1:0] state = 2'b00;
+    logic [2:0] state = 3'b000;
 
     always @(posedge strobe_clk_i) begin
         if (spi_wr_en_i) begin
-            if (spi_addr_i == 17'hE80F) state <= spi_data_i[1:0];
+            if (spi_addr_i == 17'hE80F) state <= spi_data_i[2:0];
         end
     end
     
     assign cpu_res_o   = !state[RES_N];
     assign cpu_ready_o = state[READY];
+    assign col_80_o    = state[COL_80];
 endmodule
@@ -69,12 +69,14 @@ module main(
     // SPI1
     //
 
-    logic        spi_rw_n;      // Direction (0 = Write, 1 = Read)
-    logic [16:0] spi_addr;      // 17-bit address of pending transaction
-    logic  [7:0] spi_wr_data;   // Data from MCU when writing
+    logic        spi_cmd_rw_n;  // Direction of command from MCU (0 = Write, 1 = Read)
+    logic  [1:0] spi_cmd_op;    // Read-modify-write operation of read command (0 = none)
+    logic [16:0] spi_cmd_addr;  // 17-bit address of command from MCU
+    logic  [7:0] spi_cmd_data;  // Data from MCU when writing
+    logic        spi_cmd_valid; // Command pending: spi_cmd_addr, _data, and _rw_n are valid
+    logic        spi_cmd_ready; // Command accepted: ready for next SPI command
     logic  [7:0] spi_rd_data;   // Data to MCU when reading
-    logic        spi_valid;     // Transaction pending: spi_addr, _data, and _rw_n are valid
-    logic        spi_ready;     // Transaction complete: ready for next SPI command
+    logic  [7:0] spi_status;    // Status byte returned during each SPI command byte (see 'Status')
     
     spi1 spi1(
         .clk_sys_i(clk16_i),
@@ -82,15 +84,54 @@ module main(
         .spi_cs_ni(spi1_cs_ni),
         .spi_rx_i(spi1_rx_i),
         .spi_tx_o(spi1_tx_o),
-        .spi_valid_o(spi_valid),
-        .spi_ready_i(spi_ready),
+        .spi_valid_o(spi_cmd_valid),
+        .spi_ready_i(spi_cmd_ready),
         .spi_ready_o(spi_ready_o),
-        .spi_addr_o(spi_addr),
+        .spi_addr_o(spi_cmd_addr),
         .spi_data_i(spi_rd_data),
-        .spi_data_o(spi_wr_data),
-        .spi_rw_no(spi_rw_n)
+        .spi_data_o(spi_cmd_data),
+        .spi_rw_no(spi_cmd_rw_n),
+        .spi_op_o(spi_cmd_op),
+        .spi_status_i(spi_status)
+    );
+
+    // Writes are posted to a FIFO and drained into SPI bus slots, so the MCU does not wait
+    // for a bus slot on each write.
+
+    logic        spi_req_rw_n;  // Direction of request (0 = Write, 1 = Read)
+    logic  [1:0] spi_req_op;    // Read-modify-write operation of request
+    logic [16:0] spi_req_addr;  // 17-bit address of request
+    logic  [7:0] spi_req_data;  // Data to write
+    logic        spi_req_valid; // Request pending: spi_req_addr, _data, and _rw_n are valid
+    logic        spi_req_ready; // Request complete
+
+    spi_write_fifo spi_write_fifo(
+        .clk_sys_i(clk16_i),
+        .spi_valid_i(spi_cmd_valid),
+        .spi_ready_o(spi_cmd_ready),
+        .spi_addr_i(spi_cmd_addr),
+        .spi_data_i(spi_cmd_data),
+        .spi_rw_ni(spi_cmd_rw_n),
+        .spi_op_i(spi_cmd_op),
+        .bus_valid_o(spi_req_valid),
+        .bus_ready_i(spi_req_ready),
+        .bus_addr_o(spi_req_addr),
+        .bus_data_o(spi_req_data),
+        .bus_rw_no(spi_req_rw_n),
+        .bus_op_o(spi_req_op)
     );
 
+    // Reads and writes are then issued to the bus by 'spi_read_prefetch' (see 'RAM' below),
+    // which serves sequential reads from a read-ahead buffer.
+
+    logic        spi_rw_n;      // Direction (0 = Write, 1 = Read)
+    logic [16:0] spi_addr;      // 17-bit address of pending bus transaction
+    logic  [7:0] spi_wr_data;   // Data to write
+    logic  [7:0] spi_bus_data;  // Data read from bus
+    logic        spi_valid;     // Transaction pending: spi_addr, _data, and _rw_n are valid
+    logic        spi_ready;     // Transaction complete
+    logic        spi_atomic;    // Pending read is the first half of a read-modify-write
+
     //
     // Timing
     //
@@ -98,11 +139,15 @@ module main(
     logic strobe_clk;
     logic setup_clk;
     logic cpu_en;
+    logic cclk_en;
+    logic dma_busy;                 // 'spi_dma' operation in progress
     logic spi_en;
     logic vram0_en;
     logic vrom0_en;
     logic vram1_en;
     logic vrom1_en;
+    logic video_blank;
+    logic video_80_col;
 
     timing timing(
         .clk16_i(clk16_i),
@@ -111,10 +156,15 @@ module main(
 
         .spi_en_o(spi_en),
         .spi_valid_i(spi_valid),
+        .spi_atomic_i(spi_atomic),
         .spi_ready_o(spi_ready),
+        .video_blank_i(video_blank),
+        .video_80_col_i(video_80_col),
         
         .cpu_be_o(cpu_be_o),
         .cpu_en_o(cpu_en),
+        .cclk_en_o(cclk_en),
+        .cpu_halt_i(!cpu_ready_o && dma_busy),
         .cpu_clk_o(cpu_clk_o),
 
         .vram0_en_o(vram0_en),
@@ -141,6 +191,7 @@ module main(
     logic sid_en;
     logic io_en;
     logic is_mirrored;
+    logic reg_en;
 
     address_decoding address_decoding(
         .addr_i({ bus_addr_o[16], bus_addr_i}),
@@ -151,7 +202,8 @@ module main(
         .crtc_en_o(crtc_en),
         .sid_en_o(sid_en),
         .io_en_o(io_en),
-        .is_mirrored_o(is_mirrored)
+        .is_mirrored_o(is_mirrored),
+        .reg_en_o(reg_en)
     );
     
     logic [7:0] kbd_data;
@@ -182,7 +234,8 @@ module main(
         .spi_data_i(spi_wr_data),
         .spi_wr_en_i(spi_wr_en),
         .cpu_res_o(cpu_res_o),
-        .cpu_ready_o(cpu_ready_o)
+        .cpu_ready_o(cpu_ready_o),
+        .col_80_o(video_80_col)
     );
 
     //
@@ -192,7 +245,7 @@ module main(
     audio audio(
         .reset_i(cpu_res_i),
         .clk8_i(strobe_clk),
-        .cpu_en_i(cpu_en),
+        .cpu_en_i(cclk_en),
         .cpu_wr_en_i(cpu_wr_en),
         .sid_en_i(sid_en),
         .addr_i(bus_addr_i[4:0]),
@@ -208,6 +261,7 @@ module main(
 
     logic [13:0] video_addr;
     logic        video_addr_oe;
+    logic  [7:0] crtc_spi_r;
 
     video video(
         .reset_i(cpu_res_i),
@@ -216,7 +270,7 @@ module main(
         .setup_clk_i(setup_clk),
         .strobe_clk_i(strobe_clk),
         .cpu_en_i(cpu_en),
-        .cclk_en_i(cpu_en),
+        .cclk_en_i(cclk_en),
         .vram0_en_i(vram0_en),
         .vrom0_en_i(vrom0_en),
         .vram1_en_i(vram1_en),
@@ -230,11 +284,32 @@ module main(
         .gfx_i(gfx_i),
         .h_sync_o(h_sync_o),
         .v_sync_o(v_sync_o),
-        .video_o(video_o)
+        .video_o(video_o),
+        .blank_o(video_blank),
+        .col_80_mode_i(video_80_col),
+        .crtc_spi_ar_i(spi_addr[4:0]),
+        .crtc_spi_r_o(crtc_spi_r)
     );
 
+    //
+    // Status
+    //
+
+    // 'FRAME' toggles at the start of each vertical sync so the MCU can detect new frames
+    // without observing the (brief) vertical sync itself.
+    logic v_sync_q  = '0;
+    logic frame_t   = '0;
+
+    always_ff @(posedge clk16_i) begin
+        v_sync_q <= !v_sync_o;
+        if (!v_sync_o && !v_sync_q) frame_t <= !frame_t;
+    end
+
+    assign spi_status = { 3'b000, cpu_ready_o, cpu_res_o, frame_t, !v_sync_o, gfx_i };
+
+    // Display RAM is 1KB in 40 column mode and 2KB in 80 column mode, mirrored through $8FFF.
     assign ram_addr_o[11:10] = is_mirrored && cpu_en
-        ? 2'b00 // 80 col: { 1'b0, bus_addr_i[10:10] }
+        ? { 1'b0, video_80_col && bus_addr_i[10] }
         : bus_addr_i[11:10];
 
     //
@@ -243,6 +318,113 @@ module main(
 
     assign ram_oe_o = ram_en && (spi_rd_en || cpu_rd_en || vram0_en || vrom0_en || vram1_en || vrom1_en);   // RAM output enable
     assign ram_we_o = ram_en && (spi_wr_en || cpu_wr_en) && strobe_clk;                                     // RAM write strobe
+
+    // RAM address of the current CPU or SPI write (after mirroring).
+    wire [16:0] ram_wr_addr = { bus_addr_o[16], bus_addr_i[15:12], ram_addr_o[11:10], bus_addr_i[9:0] };
+
+    logic        pf_valid;      // Transaction pending from 'spi_read_prefetch'
+    logic        pf_ready;      // Transaction from 'spi_read_prefetch' complete
+    logic        pf_rw_n;
+    logic  [1:0] pf_op;
+    logic [16:0] pf_addr;
+    logic  [7:0] pf_wr_data;
+    logic        dma_en;        // Current SPI bus transaction belongs to 'spi_dma'
+
+    // CPU and DMA engine writes invalidate overlapping prefetched SPI reads.  (Note that SPI
+    // accesses to VRAM are not mirrored, so compare the RAM address actually written.)
+    spi_read_prefetch spi_read_prefetch(
+        .clk_sys_i(clk16_i),
+        .spi_valid_i(spi_req_valid),
+        .spi_ready_o(spi_req_ready),
+        .spi_addr_i(spi_req_addr),
+        .spi_data_i(spi_req_data),
+        .spi_rw_ni(spi_req_rw_n),
+        .spi_op_i(spi_req_op),
+        .spi_data_o(spi_rd_data),
+        .bus_valid_o(pf_valid),
+        .bus_ready_i(pf_ready),
+        .bus_addr_o(pf_addr),
+        .bus_data_o(pf_wr_data),
+        .bus_rw_no(pf_rw_n),
+        .bus_op_o(pf_op),
+        .bus_data_i(spi_bus_data),
+        .wr_en_i((cpu_wr_en || (spi_wr_en && dma_en)) && ram_en),
+        .wr_addr_i(ram_wr_addr)
+    );
+
+    logic       dma_wr_en;
+    logic [7:0] dma_data;
+
+    logic        dma_valid;     // Transaction pending from 'spi_dma'
+    logic        dma_ready;     // Transaction from 'spi_dma' complete
+    logic        dma_rw_n;
+    logic [16:0] dma_addr;
+    logic  [7:0] dma_wr_data;
+    logic  [1:0] dma_op;
+
+    // The DMA engine (fill, copy, compare, CRC and March test) uses the SPI slots that the MCU
+    // leaves idle.
+    spi_dma spi_dma(
+        .clk_sys_i(clk16_i),
+        .reg_addr_i(spi_addr[3:0]),
+        .reg_wr_en_i(dma_wr_en),
+        .reg_data_i(spi_wr_data),
+        .reg_data_o(dma_data),
+        .spi_valid_i(pf_valid),
+        .spi_ready_o(pf_ready),
+        .spi_addr_i(pf_addr),
+        .spi_data_i(pf_wr_data),
+        .spi_rw_ni(pf_rw_n),
+        .spi_op_i(pf_op),
+        .bus_valid_o(dma_valid),
+        .bus_ready_i(dma_ready),
+        .bus_addr_o(dma_addr),
+        .bus_data_o(dma_wr_data),
+        .bus_rw_no(dma_rw_n),
+        .bus_op_o(dma_op),
+        .bus_data_i(spi_bus_data),
+        .dma_en_o(dma_en),
+        .busy_o(dma_busy)
+    );
+
+    // Read-modify-write commands become an atomic read followed by a write.
+    spi_rmw spi_rmw(
+        .clk_sys_i(clk16_i),
+        .spi_valid_i(dma_valid),
+        .spi_ready_o(dma_ready),
+        .spi_addr_i(dma_addr),
+        .spi_data_i(dma_wr_data),
+        .spi_rw_ni(dma_rw_n),
+        .spi_op_i(dma_op),
+        .bus_valid_o(spi_valid),
+        .bus_ready_i(spi_ready),
+        .bus_addr_o(spi_addr),
+        .bus_data_o(spi_wr_data),
+        .bus_rw_no(spi_rw_n),
+        .bus_data_i(spi_bus_data),
+        .bus_atomic_o(spi_atomic)
+    );
+
+    //
+    // SPI Registers
+    //
+
+    wire        vram_wr_en  = (cpu_wr_en || spi_wr_en) && ram_en && ram_wr_addr[16:12] == 5'b0_1000;
+
+    logic [7:0] reg_data;
+
+    spi_regs spi_regs(
+        .strobe_clk_i(strobe_clk),
+        .addr_i(spi_addr[7:0]),
+        .rd_en_i(spi_rd_en && reg_en),
+        .wr_en_i(spi_wr_en && reg_en),
+        .data_o(reg_data),
+        .vram_wr_en_i(vram_wr_en),
+        .vram_addr_i(ram_wr_addr[11:0]),
+        .crtc_r_i(crtc_spi_r),
+        .dma_wr_en_o(dma_wr_en),
+        .dma_data_i(dma_data)
+    );
     
     //
     // Bus
@@ -263,8 +445,9 @@ module main(
 
     always @(negedge strobe_clk) begin
         if (spi_rd_en) begin
-            if (spi_addr == 17'h0e80f) spi_rd_data <= { 7'h0, gfx_i };
-            else spi_rd_data <= bus_data_i;
+            if (spi_addr == 17'h0e80f) spi_bus_data <= { 7'h0, gfx_i };
+            else if (reg_en) spi_bus_data <= reg_data;
+            else spi_bus_data <= bus_data_i;
         end
     end
 endmodule
@@ -12,107 +12,214 @@
  * @author Daniel Lehenbauer <DLehenbauer@users.noreply.github.com> and contributors
  */
 
-// Implements core of SPI Mode 0 byte transfers in a controller/peripheral agnostic way.
+// Implements the peripheral side of SPI Mode 0 byte transfers.
+//
+// The shift register is clocked directly by SCK rather than oversampling SCK with 'clk_sys_i',
+// which allows SCK to run faster than 'clk_sys_i' / 4.  Received bytes cross into the
+// 'clk_sys_i' domain through a small asynchronous FIFO.
+//
+// The 'tx_byte' crosses the other direction without synchronization.  This is safe because
+// the MCU waits for READY before clocking a byte whose 'tx_byte' matters (i.e., 'tx_byte' is
+// stable while SCK is running), and 'tx_byte' is captured on the first SCK of the byte, before
+// 'busy_o' allows the FSM to fetch the next byte.
 module spi_byte (
-    input  logic clk_sys_i,         // Sampling clock
+    input  logic clk_sys_i,         // Bus clock ('rx_byte_o', 'valid_o' and 'busy_o' are synchronous to 'clk_sys_i')
 
-    input  logic spi_cs_ni,         // CS_N also functions as a synchronous reset
+    input  logic spi_cs_ni,         // CS_N also functions as an asynchronous reset
     input  logic spi_sck_i,         // SCK must be low before falling edge of CS_N
     input  logic spi_rx_i,
     output logic spi_tx_o,
 
-    output logic [7:0] rx_byte_o,   // Byte recieved.  Valid on rising edge of 'valid'.
-    input  logic [7:0] tx_byte_i,   // Byte to transmit.  Loaded on falling edges of CS_N and last SCLK of byte.
+    output logic [7:0] rx_byte_o,   // Byte recieved.  Valid while 'valid_o' is asserted.
+    input  logic [7:0] tx_byte_i,   // Byte to transmit.  Continuously reloaded between bytes (i.e., while CS_N
+                                    // is deasserted or SCK is paused after the last bit of the previous byte).
 
-    output logic valid_o            // 'rx_byte' valid pulse is high for one period of clk_sys_i.
+    output logic valid_o,           // 'rx_byte' valid pulse is high for one period of clk_sys_i.
+    output logic busy_o,            // Asserted from the 1st SCK of a byte until the byte is received.
+    output logic start_o            // Asserted asynchronously on the 1st SCK of a byte until one 'clk_sys_i'
+                                    // after 'busy_o' (allows READY to be deasserted without waiting for the CDC).
 );
-    // Signals crossing clock domain
-    logic spi_cs_nq;
-    logic spi_sck_q;
-    logic spi_rx_q;
-    logic spi_tx_d;
-
-    // Shift register simultaneously clocks in the incoming 'rx' bit at 'sr[0]' and clocks out
-    // the outgoing 'tx' bit at 'sr[7]'.
-    logic [7:0] sr_d, sr_q;
-
-    // Counts the number of bits transfered in the current byte.  Used to detect when to copy
-    // 'sr' to 'rx_byte', assert 'valid', and load the next 'tx_byte'.
-    logic [2:0] bit_count_d, bit_count_q = '0;
-
-    // 'sr' is copied to 'rx_byte' on the rising edge of the 'valid' pulse.
-    logic [7:0] rx_byte_d;
-    logic valid_d;
-
-    // Detect positive and negative edges of 'spi_sck_q'.
-    logic spi_sck_q2;
-    wire spi_sck_pe = !spi_sck_q2 &&  spi_sck_q;
-    wire spi_sck_ne =  spi_sck_q2 && !spi_sck_q;
-
-    always_comb begin
-        // Signals crossing clock domain
-        spi_tx_d    = spi_tx_o;        
-        sr_d        = sr_q;
-        bit_count_d = bit_count_q;
-        rx_byte_d   = rx_byte_o;
-        valid_d     = '0;
-
-        if (spi_cs_nq) begin
-            // Deasserting 'CS' resets the SPI state machine.
-            bit_count_d = '0;
-
-            // Reset 'valid' pulse
-            valid_d     = '0;
-
-            // Preload 'tx_byte' while 'CS' is deasserted so it is ready to transfer on the
-            // first 'SCK'.
-            sr_d        = tx_byte_i;
-            spi_tx_d    = tx_byte_i[7];
+    //
+    // SCK domain
+    //
+
+    logic [2:0] bit_count = '0;     // Number of bits transfered in the current byte
+    logic       sck_busy  = '0;     // Byte in progress (i.e., 1st SCK has been received)
+    logic       start_t   = '0;     // Toggles on the 1st SCK of each byte
+    logic [6:0] rx_sr;              // Bits received so far
+    logic [7:0] tx_sr;              // Remaining bits to transmit ('tx_sr[7]' is next)
+    logic       tx_q;               // Outgoing bit, updated on falling edge of SCK
+    logic       tx_sel = '0;        // Selects 'tx_q' vs. 'tx_byte[7]', updated on falling edge of SCK
+
+    // Received bytes.  Must cover the longest run of bytes the MCU sends without waiting for
+    // READY (i.e., the 4 byte header of WRITE_AT, AND_AT, etc.).  The pointers carry an extra
+    // bit so that 4 unread bytes are distinguishable from none.  There is no backpressure; the
+    // MCU must never send more than 4 bytes without waiting for READY.
+    logic [7:0] fifo[4];
+    logic [2:0] wr_bin  = '0;
+    logic [2:0] wr_gray = '0;
+
+    wire [7:0] rx_next  = { rx_sr, spi_rx_i };
+    wire [2:0] wr_inc   = wr_bin + 1'b1;
+
+    always_ff @(posedge spi_sck_i or posedge spi_cs_ni) begin
+        if (spi_cs_ni) begin
+            bit_count <= '0;
+            sck_busy  <= '0;
+            wr_bin    <= '0;
+            wr_gray   <= '0;
         end else begin
-            if (spi_sck_pe) begin
-                // On the positive edge of 'spi_sck' we shift the incoming 'rx' bit into 'sr'
-                // and incement our 'bit_count'.  This simultaneously shifts the next outgoing
-                // bit of 'tx_byte' to sr[7].
-                sr_d        = { sr_q[6:0], spi_rx_q };
-                bit_count_d = bit_count_q + 1'b1;
-
-                if (bit_count_q == 3'd7) begin
-                    // We've received the last bit of 'rx_byte'.  Store it in 'rx_byte' and raise
-                    // the 'valid' pulse.
-                    rx_byte_d = { sr_q[6:0], spi_rx_q };
-                    valid_d   = 1'b1;
-                end
-            end else if (spi_sck_ne) begin
-                if (bit_count_q == 3'd0) begin
-                    // We transmitted the last bit of the previous 'tx_byte' on the positive edge
-                    // of SCLK.  Load the next value of 'tx_byte' into 'sr' on the negative edge.
-                    sr_d     = tx_byte_i;
-                    spi_tx_d = tx_byte_i[7];
-                end else begin
-                    // Prepare 'spi_tx' with the next outgoing bit of 'tx_byte' so it's available
-                    // on the next positive edge SCLK.
-                    spi_tx_d = sr_q[7];
-                end
+            bit_count <= bit_count + 1'b1;
+            sck_busy  <= bit_count != 3'd7;
+
+            if (bit_count == 3'd7) begin
+                wr_bin  <= wr_inc;
+                wr_gray <= wr_inc ^ (wr_inc >> 1);
             end
         end
     end
 
-    always_ff @(posedge clk_sys_i) begin
-        bit_count_q <= bit_count_d;
-        sr_q        <= sr_d;
+    always_ff @(posedge spi_sck_i) begin
+        // SCK is shared with the SD card.  Ignore SCK while CS_N is deasserted.
+        if (!spi_cs_ni) begin
+            rx_sr <= rx_next[6:0];
 
-        spi_cs_nq   <= spi_cs_ni;
-        spi_sck_q   <= spi_sck_i;
-        spi_sck_q2  <= spi_sck_q;
-        spi_rx_q    <= spi_rx_i;
-        spi_tx_o    <= spi_tx_d;
+            if (bit_count == 3'd0) begin
+                // 'tx_byte[7]' is already on the wire.  Capture the remaining bits.
+                tx_sr   <= { tx_byte_i[6:0], 1'b0 };
+                start_t <= !start_t;
+            end else begin
+                tx_sr   <= { tx_sr[6:0], 1'b0 };
+            end
 
-        rx_byte_o   <= rx_byte_d;
-        valid_o     <= valid_d;
+            if (bit_count == 3'd7) fifo[wr_bin[1:0]] <= rx_next;
+        end
     end
+
+    always_ff @(negedge spi_sck_i or posedge spi_cs_ni) begin
+        if (spi_cs_ni) begin
+            tx_sel <= '0;
+        end else begin
+            tx_q   <= tx_sr[7];
+            tx_sel <= sck_busy;
+        end
+    end
+
+    // Between bytes, continuously present the MSB of 'tx_byte'.  This allows the MCU to pause
+    // SCK between bytes while waiting for the FPGA to produce the next 'tx_byte' (e.g., during
+    // a burst read).  'spi_tx' only changes on the falling edge of SCK so that it is stable for
+    // the entire high phase.
+    assign spi_tx_o = tx_sel
+        ? tx_q
+        : tx_byte_i[7];
+
+    //
+    // clk_sys domain
+    //
+
+    logic [2:0] wr_gray_s1, wr_gray_s2;
+    logic [2:0] rd_bin;
+    wire  [2:0] rd_gray = rd_bin ^ (rd_bin >> 1);
+    wire        pop     = wr_gray_s2 != rd_gray;
+
+    logic [1:0] start_s = '0;
+    logic       start_q = '0;
+    logic       start_q2 = '0;
+    wire        start   = start_s[1] != start_q;
+    logic       busy_q;             // Byte started, but not yet received
+
+    always_ff @(posedge clk_sys_i or posedge spi_cs_ni) begin
+        if (spi_cs_ni) begin
+            wr_gray_s1 <= '0;
+            wr_gray_s2 <= '0;
+            rd_bin     <= '0;
+            valid_o    <= '0;
+            busy_q     <= '0;
+        end else begin
+            wr_gray_s1 <= wr_gray;
+            wr_gray_s2 <= wr_gray_s1;
+            valid_o    <= pop;
+
+            if (pop) begin
+                rx_byte_o <= fifo[rd_bin[1:0]];
+                rd_bin    <= rd_bin + 1'b1;
+            end
+
+            if (start) busy_q <= 1'b1;
+            else if (pop) busy_q <= '0;
+        end
+    end
+
+    always_ff @(posedge clk_sys_i) begin
+        start_s  <= { start_s[0], start_t };
+        start_q  <= start_s[1];
+        start_q2 <= start_q;
+    end
+
+    assign busy_o  = busy_q || start;
+    assign start_o = start_t != start_q2;
 endmodule
 
 // Protocol for SPI1 peripheral
+//
+// Each command begins with a command byte, optionally followed by arguments:
+//
+//   [7]   rw_n     0 = write, 1 = read
+//   [6]   A        1 = command sets the address (address follows as 'addr_hi, addr_lo')
+//   [5]   B        1 = burst (stream data bytes until CS_N is deasserted)
+//   [4]   C        1 = counted burst (length byte follows the address, 0 = 256)
+//   [0]   A16      17th bit of address (if A = 1)
+//
+//   WRITE_AT     0100_000a, data, addr_hi, addr_lo
+//   WRITE_NEXT   0000_0000, data
+//   READ_AT      1100_000a, addr_hi, addr_lo
+//   READ_NEXT    1000_0000, data                   (returns the byte at the current address)
+//
+//   WRITE_BURST  0110_000a, addr_hi, addr_lo, data[0], ..., data[n-1]
+//   READ_BURST   1110_000a, addr_hi, addr_lo, data[0], ..., data[n-1]
+//
+//   WRITE_COUNT  0111_000a, addr_hi, addr_lo, n, data[0], ..., data[n-1]
+//   READ_COUNT   1111_000a, addr_hi, addr_lo, n, data[0], ..., data[n-1]
+//
+//   AND_AT       1100_001a, mask, addr_hi, addr_lo, old
+//   OR_AT        1100_010a, mask, addr_hi, addr_lo, old
+//   XOR_AT       1100_011a, mask, addr_hi, addr_lo, old
+//
+// Omitting the 'A' bit from a burst continues at the next address.
+//
+// READ_AT fetches the byte at 'addr' and advances the address, and READ_NEXT returns the fetched
+// byte and fetches the following one, so READ_AT followed by READ_NEXTs returns sequential bytes.
+// Counted bursts and AND_AT, OR_AT and XOR_AT return every byte they fetch, so a READ_NEXT that
+// follows them (or a write) first fetches the byte at the current address.
+//
+// AND_AT, OR_AT and XOR_AT atomically replace the byte at 'addr' with 'byte op mask' and return
+// the original byte (see 'spi_rmw').  The FPGA asserts READY before the 'old' byte.
+//
+// The byte returned to the MCU during the command byte of every command is a status byte:
+//
+//   [0]   GFX        Graphics character set selected
+//   [1]   VSYNC      Video is in vertical sync
+//   [2]   FRAME      Toggles at the start of each vertical sync
+//   [3]   CPU_RES    CPU is held in reset
+//   [4]   CPU_RDY    CPU is running
+//   [7:5]            Reserved (0)
+//
+// The status byte is sampled when the FPGA asserts READY at the end of the previous command (or
+// while CS_N is deasserted), so it is stable while the MCU clocks the command byte.
+//
+// Every command other than an uncounted burst ends in the DONE state with READY asserted.
+// From DONE, the MCU may either deassert CS_N or begin the next command without deasserting
+// CS_N.  This allows the MCU to execute a batch of commands in a single CS_N frame.
+//
+// For single transfers, the MCU holds CS_N low until the FPGA asserts READY and then
+// deasserts CS_N.  READ_NEXT also asserts READY before its data byte.  For bursts, the FPGA
+// asserts READY before each data byte to signal that it is ready to receive (write) or has
+// fetched (read) the next byte.  READY is deasserted when the MCU begins transferring the
+// next byte.  The MCU must wait for READY before each
+// data byte so that it never overruns the FSM while it waits for its bus slot.
+//
+// Writes are posted (see 'spi_write_fifo'), so READY after a write only indicates that the
+// write has been queued.  Reads wait for all queued writes to complete.
 module spi1(
     input  logic clk_sys_i,         // Sampling / FSM clock
 
@@ -128,7 +235,10 @@ module spi1(
     output logic [16:0] spi_addr_o, // Bus address of pending read/write command
     input  logic  [7:0] spi_data_i, // Data returned from completed read command
     output logic  [7:0] spi_data_o, // Data to be written by pending write command
-    output logic        spi_rw_no   // Direction of pending command (0 = write, 1 = read)
+    output logic        spi_rw_no,  // Direction of pending command (0 = write, 1 = read)
+    output logic  [1:0] spi_op_o,   // Read-modify-write operation of pending read command (0 = none)
+
+    input  logic  [7:0] spi_status_i // Status byte returned during each command byte
 );
     // State encoding for our FSM:
     //
@@ -136,18 +246,39 @@ module spi1(
     //  A = address     (processing a random access command, awaiting address bytes)
     //  V = spi_valid_o (a command has been received)
     //  R = spi_ready_o (signals to MCU that command has finished processing)
+    //  B = burst       (processing a burst command, streaming data bytes)
     //
-    //                                RVAD
-    localparam READ_CMD          = 4'b0000,
-               READ_DATA_ARG     = 4'b0001,
-               READ_ADDR_HI_ARG  = 4'b0010,
-               READ_ADDR_LO_ARG  = 4'b0011,
-               XFER              = 4'b0100,
-               DONE              = 4'b1000;
-
-    logic [3:0] state = READ_CMD;   // Current state of FSM
+    //                                BRVAD
+    localparam READ_CMD          = 5'b00000,
+               READ_DATA_ARG     = 5'b00001,
+               READ_ADDR_HI_ARG  = 5'b00010,
+               READ_ADDR_LO_ARG  = 5'b00011,
+               XFER              = 5'b00100,
+               DONE              = 5'b01000,
+               BURST_RX          = 5'b10000,
+               READ_LEN_ARG      = 5'b10001,
+               BURST_LAST        = 5'b10010,
+               BURST_XFER        = 5'b10100,
+               BURST_READY       = 5'b11000,
+               NEXT_XFER         = 5'b00101,
+               NEXT_READY        = 5'b01001,
+               NEXT_RX           = 5'b10011,
+               RESULT_READY      = 5'b01010;
+
+    logic [4:0] state = READ_CMD;   // Current state of FSM
     logic       rx_valid;           // Asserted by 'spi_byte' when a byte has been received
+    logic       rx_busy;            // Asserted by 'spi_byte' while a byte is being transfered
+    logic       rx_start;           // Asserted by 'spi_byte' (asynchronously) when the MCU begins a byte
     logic [7:0] rx;                 // Next received byte to decode
+
+    // The status byte is transmitted during the command byte, which the MCU may begin clocking
+    // while in the READ_CMD or DONE state.  Hold 'status' constant in these states.
+    wire        tx_status = state == READ_CMD || state == DONE;
+    logic [7:0] status;
+
+    always_ff @(posedge clk_sys_i) begin
+        if (spi_cs_ni || !tx_status) status <= spi_status_i;
+    end
     
     spi_byte spi_byte(
         .clk_sys_i(clk_sys_i),
@@ -156,14 +287,26 @@ module spi1(
         .spi_rx_i(spi_rx_i),
         .spi_tx_o(spi_tx_o),
         .rx_byte_o(rx),
-        .tx_byte_i(spi_data_i),
-        .valid_o(rx_valid)
+        .tx_byte_i(tx_status ? status : spi_data_i),
+        .valid_o(rx_valid),
+        .busy_o(rx_busy),
+        .start_o(rx_start)
     );
     
     logic cmd_rd_a;
+    logic cmd_burst;
+    logic cmd_count;
+    logic [1:0] cmd_op;             // Read-modify-write operation (AND_AT, OR_AT, XOR_AT), or 0
+    logic [8:0] burst_count;        // Remaining bytes to fetch/write for counted bursts
+    logic       fetched = '0;       // 'spi_data_i' holds a fetched byte not yet returned to the MCU
 
     assign spi_valid_o = state[2];
-    assign spi_ready_o = state[3];
+    assign spi_op_o    = cmd_op;
+
+    // Deassert READY as soon as the MCU begins the next byte.  The FSM leaves the ready state
+    // once 'rx_busy' crosses into the 'clk_sys_i' domain, which may take longer than the byte
+    // at high SCK rates.
+    assign spi_ready_o = state[3] && !rx_start;
 
     always_ff @(posedge clk_sys_i or posedge spi_cs_ni) begin
         if (spi_cs_ni) begin
@@ -174,14 +317,28 @@ module spi1(
                     if (rx_valid) begin
                         spi_rw_no <= rx[7];
                         cmd_rd_a  <= rx[6];
+                        cmd_burst <= rx[5];
+                        cmd_count <= rx[4];
+                        cmd_op    <= rx[7:4] == 4'b1100 ? rx[2:1] : 2'b00;
 
                         // If CMD sets address capture A16 from rx[0] now.
                         if (rx[6]) spi_addr_o <= { rx[0], 16'hxxxx };
 
                         unique casez(rx)
-                            8'b0???????: state <= READ_DATA_ARG;
-                            8'b11??????: state <= READ_ADDR_HI_ARG;
-                            default:     state <= XFER;
+                            8'b0?0?????: state <= READ_DATA_ARG;        // WRITE_AT, WRITE_NEXT
+                            8'b0010????: state <= BURST_READY;          // WRITE_BURST (next)
+                            8'b0011????: state <= READ_LEN_ARG;         // WRITE_COUNT (next)
+                            8'b011?????: state <= READ_ADDR_HI_ARG;     // WRITE_BURST, WRITE_COUNT
+                            8'b100?????: state <= fetched               // READ_NEXT
+                                ? NEXT_READY
+                                : NEXT_XFER;
+                            8'b1010????: state <= BURST_XFER;           // READ_BURST (next)
+                            8'b1011????: state <= READ_LEN_ARG;         // READ_COUNT (next)
+                            8'b1100?00?: state <= READ_ADDR_HI_ARG;     // READ_AT
+                            8'b1100?01?,
+                            8'b1100?1??: state <= READ_DATA_ARG;        // AND_AT, OR_AT, XOR_AT
+                            8'b1101????,
+                            8'b111?????: state <= READ_ADDR_HI_ARG;     // READ_AT (C ignored), READ_BURST, READ_COUNT
                         endcase
                     end
                 end
@@ -205,22 +362,111 @@ module spi1(
                 READ_ADDR_LO_ARG: begin
                     if (rx_valid) begin
                         spi_addr_o <= { spi_addr_o[16:8], rx };
-                        state      <= XFER;
+
+                        // Burst reads fetch the first byte immediately so that it is ready
+                        // to transmit when the MCU clocks the first data byte.  Burst writes
+                        // wait for the first data byte.
+                        if (!cmd_burst) state <= XFER;
+                        else if (cmd_count) state <= READ_LEN_ARG;
+                        else state <= spi_rw_no
+                            ? BURST_XFER
+                            : BURST_READY;
                     end
                 end
 
+                READ_LEN_ARG: begin
+                    if (rx_valid) begin
+                        burst_count <= { rx == 8'h00, rx };     // 0 = 256
+                        state <= spi_rw_no
+                            ? BURST_XFER
+                            : BURST_READY;
+                    end
+                end
+
+                NEXT_XFER: begin
+                    // READ_NEXT: The previous command returned the last byte it fetched.  Fetch
+                    // the byte at the current address before asserting READY.
+                    if (spi_ready_i) begin
+                        spi_addr_o <= spi_addr_o + 1'b1;
+                        fetched    <= 1'b1;
+                        state      <= NEXT_READY;
+                    end
+                end
+
+                NEXT_READY: begin
+                    // READ_NEXT: Wait for the MCU to begin the data byte, which returns the data
+                    // from the previous read.
+                    if (rx_busy) state <= NEXT_RX;
+                end
+
+                NEXT_RX: begin
+                    // Wait for the data byte to finish before reading the next address (which
+                    // updates 'spi_data_i').
+                    if (rx_valid) state <= XFER;
+                end
+
                 XFER: begin
                     if (spi_ready_i) begin
                         spi_addr_o <= spi_addr_o + 1'b1;
-                        state <= DONE;
+                        fetched    <= spi_rw_no && cmd_op == 2'b00;
+                        state <= cmd_op != 2'b00
+                            ? RESULT_READY
+                            : DONE;
+                    end
+                end
+
+                RESULT_READY: begin
+                    // AND_AT, OR_AT, XOR_AT: Wait for the MCU to begin the data byte, which returns
+                    // the original byte.  Then wait for it to finish transmitting.
+                    if (rx_busy) state <= BURST_LAST;
+                end
+
+                BURST_READY: begin
+                    // Wait for the MCU to begin transferring the next data byte.  When reading,
+                    // 'spi_byte' has already loaded the fetched byte into its shift register and
+                    // we can immediately begin fetching the following byte.
+                    if (rx_busy) begin
+                        fetched <= '0;
+                        if (!spi_rw_no) state <= BURST_RX;
+                        else if (cmd_count && burst_count == '0) state <= BURST_LAST;
+                        else state <= BURST_XFER;
+                    end
+                end
+
+                BURST_RX: begin
+                    if (spi_rw_no) begin
+                        // Reading: Wait for the current byte to finish transmitting.
+                        if (!rx_busy) state <= BURST_READY;
+                    end else if (rx_valid) begin
+                        // Writing: Wait for the next byte to write.
+                        spi_data_o <= rx;
+                        state      <= BURST_XFER;
                     end
                 end
 
+                BURST_XFER: begin
+                    if (spi_ready_i) begin
+                        spi_addr_o  <= spi_addr_o + 1'b1;
+                        burst_count <= burst_count - 1'b1;
+                        fetched     <= spi_rw_no;
+
+                        if (spi_rw_no) state <= BURST_RX;
+                        else if (cmd_count && burst_count == 9'd1) state <= DONE;
+                        else state <= BURST_READY;
+                    end
+                end
+
+                BURST_LAST: begin
+                    // Reading: All bytes of the counted burst (or the original byte of a
+                    // read-modify-write) have been fetched.  Wait for the last byte to finish
+                    // transmitting.
+                    if (!rx_busy) state <= DONE;
+                end
+
                 default: /* DONE */ begin
-                    // Remain in 'DONE' state until '_cs_n' is deasserted, signaling that the
-                    // MCU is beginning a new command.
-                    //
-                    // TODO: Review if DONE and READ_CMD could be a single state.
+                    // Remain in 'DONE' state until '_cs_n' is deasserted or the MCU begins
+                    // the next command in the same CS_N frame.
+                    if (rx_busy) state <= READ_CMD;
                 end
             endcase
         end
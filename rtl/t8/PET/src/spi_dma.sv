@@ -0,0 +1,246 @@
+/**
+ * PET Clone - Open hardware implementation of the Commodore PET
+ * by Daniel Lehenbauer and contributors.
+ * 
+ * https://github.com/DLehenbauer/commodore-pet-clone
+ *
+ * To the extent possible under law, I, Daniel Lehenbauer, have waived all
+ * copyright and related or neighboring rights to this project. This work is
+ * published from the United States.
+ *
+ * @copyright CC0 http://creativecommons.org/publicdomain/zero/1.0/
+ * @author Daniel Lehenbauer <DLehenbauer@users.noreply.github.com> and contributors
+ */
+
+// Fills, copies, compares, hashes or tests blocks of RAM using SPI bus slots that the MCU leaves
+// idle, so that bulk memory operations run at bus speed rather than link speed.  (For example, the ROM set
+// staged in the upper 64 KB bank ($1xxxx) is restored to the PET's address space with a single
+// SPI command, rather than sent over SPI on every reset.)
+//
+// Sits between 'spi_read_prefetch' and 'timing'.  SPI transactions from the MCU take priority;
+// the engine issues its reads and writes only while the MCU has no transaction pending.  Each
+// byte costs one bus write (FILL), a read and a write (COPY), two reads (COMPARE), one read
+// (CRC), or a read and a write (MARCH).
+//
+// Bytes whose source or destination falls in an $xE8xx page (the I/O page or the SPI register
+// page) are skipped, because accesses there are not side-effect free.  (FILL and MARCH ignore
+// SRC, and CRC ignores DST.)
+//
+// MARCH performs one element of a byte-wide March test (e.g., March C- with the $00/$FF data
+// backgrounds) over DST, testing all 8 bits of each byte in one bus cycle.  Each byte is read
+// and all bits are verified against FILL[0].  Unless FILL[2] is set, the inverted byte is then
+// written back (i.e., 'r0,w1' or 'r1,w0').  With FILL[2], each byte is only read ('r0' or 'r1').
+//
+// Registers (see 'spi_regs'):
+//
+//   +0..+2  SRC     17-bit source address, little endian
+//   +3..+5  DST     17-bit destination address, little endian
+//   +6      FILL    Value written by FILL.  For MARCH, bit 0 is the expected value, bit 1 selects
+//                   descending order (DST decrements), and bit 2 selects a read only element.
+//   +7      OP      Operation: 0 = COPY (SRC to DST), 1 = FILL (DST), 2 = COMPARE (SRC with DST),
+//                   3 = CRC (SRC), 4 = MARCH (DST)
+//   +8..+9  LEN     Byte count, little endian (0 = 64 KB).  Writing the high byte starts the
+//                   operation, so a burst write of +0..+9 is a single SPI command.
+//   +A      STATUS  Bit 0 is set while an operation is in progress.  Bit 1 is set when COMPARE
+//                   or MARCH stopped at a mismatch.  Bits 4-6 hold the failing bit for MARCH
+//                   (the lowest mismatched bit, or the highest for descending elements).
+//   +B..+E  CRC     CRC-32 of the bytes read by the last CRC operation, little endian (read only).
+//                   Uses the common reflected polynomial $EDB88320 with initial value and final
+//                   XOR of $FFFFFFFF (as zlib's 'crc32()').
+//   +F      ACTUAL  Byte read from DST when COMPARE or MARCH stopped at a mismatch.
+//
+// Reading SRC, DST and LEN returns the address of the next byte and the number of bytes
+// remaining.  When COMPARE finds a mismatch, SRC and DST hold the addresses of the mismatched
+// bytes, and MARCH leaves DST at the failing byte.
+module spi_dma(
+    input  logic clk_sys_i,
+
+    // Register access from 'spi_regs'
+    input  logic  [3:0] reg_addr_i,     // Register offset
+    input  logic        reg_wr_en_i,    // SPI write to register (bus cycle)
+    input  logic  [7:0] reg_data_i,     // Data to write
+    output logic  [7:0] reg_data_o,     // Value of register 'reg_addr_i'
+
+    // From 'spi_read_prefetch'
+    input  logic        spi_valid_i,    // SPI transaction pending: '_addr_i', '_data_i', and '_rw_ni' are valid
+    output logic        spi_ready_o,    // SPI transaction completed
+    input  logic [16:0] spi_addr_i,
+    input  logic  [7:0] spi_data_i,
+    input  logic        spi_rw_ni,
+    input  logic  [1:0] spi_op_i,       // Read-modify-write operation (see 'spi_rmw')
+
+    // To bus
+    output logic        bus_valid_o,    // Bus transaction pending: '_addr_o', '_data_o', and '_rw_no' are valid
+    input  logic        bus_ready_i,    // Bus transaction completed (from 'timing')
+    output logic [16:0] bus_addr_o,
+    output logic  [7:0] bus_data_o,
+    output logic        bus_rw_no,
+    output logic  [1:0] bus_op_o,
+    input  logic  [7:0] bus_data_i,     // Data read by completed bus transaction
+
+    output logic        dma_en_o,       // Current bus transaction belongs to the engine
+    output logic        busy_o          // Operation in progress
+);
+    localparam COPY    = 3'd0,
+               FILL    = 3'd1,
+               COMPARE = 3'd2,
+               CRC     = 3'd3,
+               MARCH   = 3'd4;
+
+    logic [16:0] src;
+    logic [16:0] dst;
+    logic [15:0] len;
+    logic  [7:0] fill;
+    logic  [2:0] op;
+    logic  [7:0] data;                  // Byte read from 'src' (or to write back for MARCH)
+    logic  [7:0] actual;                // Byte read from 'dst' at mismatch
+    logic  [2:0] bit_index;             // Failing bit when MARCH stopped at a mismatch
+    logic        busy     = '0;         // Operation in progress
+    logic        mismatch = '0;         // COMPARE or MARCH stopped at a mismatch
+    logic        dst_phase = '0;        // Next access is to 'dst' (otherwise 'src'), or write for MARCH
+    logic [31:0] crc;                   // CRC-32 remainder (before final XOR)
+
+    function automatic logic [31:0] crc32_byte(input logic [31:0] remainder, input logic [7:0] value);
+        remainder = remainder ^ { 24'h0, value };
+        for (int i = 0; i < 8; i++) begin
+            remainder = remainder[0] ? (remainder >> 1) ^ 32'hEDB88320 : remainder >> 1;
+        end
+        return remainder;
+    endfunction
+
+    // Index of the lowest set bit in 'value' (which must be non-zero).
+    function automatic logic [2:0] lowest_bit(input logic [7:0] value);
+        lowest_bit = '0;
+        for (int i = 7; i >= 0; i--) begin
+            if (value[i]) lowest_bit = i[2:0];
+        end
+    endfunction
+
+    // Index of the highest set bit in 'value' (which must be non-zero).
+    function automatic logic [2:0] highest_bit(input logic [7:0] value);
+        highest_bit = '0;
+        for (int i = 0; i < 8; i++) begin
+            if (value[i]) highest_bit = i[2:0];
+        end
+    endfunction
+
+    // 'bus_ready_i' is asserted for one 'setup_clk' period (two 'clk_sys_i' cycles).  Only
+    // respond to its rising edge.
+    logic bus_ready_q = '0;
+    wire  bus_done = bus_ready_i && !bus_ready_q;
+
+    // Ownership of the bus is decided when a transaction is first presented and held until it
+    // completes, so that neither requester's transaction is switched out from under 'timing'.
+    logic lock  = '0;
+    logic owner = '0;                   // 0 = SPI, 1 = engine (while 'lock')
+
+    wire march   = op == MARCH;
+    wire down    = march && fill[1];    // MARCH in descending order
+    wire rd_only = march && fill[2];    // MARCH element without writes
+
+    wire uses_src = op == COPY || op == COMPARE || op == CRC;
+    wire skip     = (op != CRC && dst[15:8] == 8'hE8) || (uses_src && src[15:8] == 8'hE8);
+    wire dma_req = busy && !skip;
+    wire grant   = lock ? owner : !spi_valid_i && dma_req;
+
+    // 'reg_wr_en_i' spans several 'clk_sys_i' cycles.  Only respond to its rising edge.
+    logic reg_wr_q = '0;
+    wire  reg_wr = reg_wr_en_i && !reg_wr_q;
+
+    wire dma_done = bus_done && lock && owner;
+
+    // MARCH reads in the first phase (and read only elements never leave it).
+    wire [7:0] march_diff = bus_data_i ^ {8{fill[0]}};
+    wire march_fail = dma_done && march && !dst_phase && march_diff != '0;
+
+    wire differ   = (dma_done && dst_phase && op == COMPARE && bus_data_i != data) || march_fail;
+    wire last     = op == CRC || rd_only || dst_phase;
+    wire advance  = busy && (dma_done ? last && !differ : skip);
+
+    always_ff @(posedge clk_sys_i) begin
+        bus_ready_q <= bus_ready_i;
+        reg_wr_q    <= reg_wr_en_i;
+
+        if (!lock && bus_valid_o) begin
+            lock  <= 1'b1;
+            owner <= grant;
+        end else if (bus_done) begin
+            lock  <= '0;
+        end
+
+        if (dma_done && !dst_phase) begin
+            data      <= march ? ~bus_data_i : bus_data_i;
+            dst_phase <= op != CRC && !rd_only;
+            if (op == CRC) crc <= crc32_byte(crc, bus_data_i);
+        end
+
+        if (differ) begin
+            busy     <= '0;
+            mismatch <= 1'b1;
+            actual   <= bus_data_i;
+            if (march) bit_index <= down ? highest_bit(march_diff) : lowest_bit(march_diff);
+        end
+
+        if (advance) begin
+            src       <= down ? src - 1'b1 : src + 1'b1;
+            dst       <= down ? dst - 1'b1 : dst + 1'b1;
+            len       <= len - 1'b1;
+            dst_phase <= op == FILL;
+            if (len == 16'd1) busy <= '0;
+        end
+
+        if (reg_wr) begin
+            case (reg_addr_i)
+                4'd0: src[7:0]   <= reg_data_i;
+                4'd1: src[15:8]  <= reg_data_i;
+                4'd2: src[16]    <= reg_data_i[0];
+                4'd3: dst[7:0]   <= reg_data_i;
+                4'd4: dst[15:8]  <= reg_data_i;
+                4'd5: dst[16]    <= reg_data_i[0];
+                4'd6: fill       <= reg_data_i;
+                4'd7: op         <= reg_data_i[2:0];
+                4'd8: len[7:0]   <= reg_data_i;
+                4'd9: begin
+                    len[15:8] <= reg_data_i;
+                    busy      <= 1'b1;
+                    mismatch  <= '0;
+                    dst_phase <= op == FILL;
+                    bit_index <= '0;
+                    crc       <= '1;
+                end
+                default: ;
+            endcase
+        end
+    end
+
+    always_comb begin
+        case (reg_addr_i)
+            4'd0: reg_data_o = src[7:0];
+            4'd1: reg_data_o = src[15:8];
+            4'd2: reg_data_o = { 7'h0, src[16] };
+            4'd3: reg_data_o = dst[7:0];
+            4'd4: reg_data_o = dst[15:8];
+            4'd5: reg_data_o = { 7'h0, dst[16] };
+            4'd6: reg_data_o = fill;
+            4'd7: reg_data_o = { 5'h0, op };
+            4'd8: reg_data_o = len[7:0];
+            4'd9: reg_data_o = len[15:8];
+            4'd10: reg_data_o = { 1'b0, bit_index, 2'b00, mismatch, busy };
+            4'd11: reg_data_o = ~crc[7:0];
+            4'd12: reg_data_o = ~crc[15:8];
+            4'd13: reg_data_o = ~crc[23:16];
+            4'd14: reg_data_o = ~crc[31:24];
+            4'd15: reg_data_o = actual;
+            default: reg_data_o = '0;
+        endcase
+    end
+
+    assign bus_valid_o = grant ? dma_req : spi_valid_i;
+    assign bus_addr_o  = grant ? (dst_phase || march ? dst : src) : spi_addr_i;
+    assign bus_data_o  = grant ? (op == FILL ? fill : data) : spi_data_i;
+    assign bus_rw_no   = grant ? !dst_phase || op == COMPARE : spi_rw_ni;
+    assign bus_op_o    = grant ? 2'b00 : spi_op_i;
+    assign spi_ready_o = bus_ready_i && lock && !owner;
+    assign dma_en_o    = lock && owner;
+    assign busy_o      = busy;
+endmodule
@@ -0,0 +1,304 @@
+/**
+ * PET Clone - Open hardware implementation of the Commodore PET
+ * by Daniel Lehenbauer and contributors.
+ * 
+ * https://github.com/DLehenbauer/commodore-pet-clone
+ *
+ * To the extent possible under law, I, Daniel Lehenbauer, have waived all
+ * copyright and related or neighboring rights to this project. This work is
+ * published from the United States.
+ *
+ * @copyright CC0 http://creativecommons.org/publicdomain/zero/1.0/
+ * @author Daniel Lehenbauer <DLehenbauer@users.noreply.github.com> and contributors
+ */
+
+// Posts SPI writes so that the MCU does not wait for a bus slot.
+//
+// Writes from 'spi1' are acknowledged in the same 'clk_sys_i' cycle they are received (unless
+// the FIFO is full) and drained into the bus one per SPI slot.  Reads are not posted.  A read
+// waits until all preceding writes have drained and then passes through to the bus, so reads
+// always observe earlier writes.
+module spi_write_fifo #(
+    parameter DEPTH_LOG2 = 4            // FIFO holds 2^DEPTH_LOG2 writes
+)(
+    input  logic clk_sys_i,
+
+    // From 'spi1'
+    input  logic        spi_valid_i,    // SPI command pending: '_addr_i', '_data_i', and '_rw_ni' are valid
+    output logic        spi_ready_o,    // SPI command accepted (write) or completed (read)
+    input  logic [16:0] spi_addr_i,
+    input  logic  [7:0] spi_data_i,
+    input  logic        spi_rw_ni,
+    input  logic  [1:0] spi_op_i,       // Read-modify-write operation (reads only)
+
+    // To bus
+    output logic        bus_valid_o,    // Bus transaction pending: '_addr_o', '_data_o', and '_rw_no' are valid
+    input  logic        bus_ready_i,    // Bus transaction completed (from 'spi_read_prefetch')
+    output logic [16:0] bus_addr_o,
+    output logic  [7:0] bus_data_o,
+    output logic        bus_rw_no,
+    output logic  [1:0] bus_op_o
+);
+    localparam DEPTH = 1 << DEPTH_LOG2;
+
+    logic [16:0] addr_fifo[DEPTH];
+    logic  [7:0] data_fifo[DEPTH];
+
+    // Pointers have an extra bit to distinguish full from empty.
+    logic [DEPTH_LOG2:0] wr_ptr = '0;
+    logic [DEPTH_LOG2:0] rd_ptr = '0;
+
+    wire empty = wr_ptr == rd_ptr;
+    wire full  = wr_ptr == { !rd_ptr[DEPTH_LOG2], rd_ptr[DEPTH_LOG2-1:0] };
+
+    wire [DEPTH_LOG2-1:0] wr_index = wr_ptr[DEPTH_LOG2-1:0];
+    wire [DEPTH_LOG2-1:0] rd_index = rd_ptr[DEPTH_LOG2-1:0];
+
+    // Only respond to the rising edge of 'bus_ready_i'.
+    logic bus_ready_q = '0;
+    wire  bus_done = bus_ready_i && !bus_ready_q;
+
+    wire push = spi_valid_i && !spi_rw_ni && !full;
+    wire pop  = bus_done && !empty;
+
+    always_ff @(posedge clk_sys_i) begin
+        bus_ready_q <= bus_ready_i;
+
+        if (push) begin
+            addr_fifo[wr_index] <= spi_addr_i;
+            data_fifo[wr_index] <= spi_data_i;
+            wr_ptr <= wr_ptr + 1'b1;
+        end
+
+        if (pop) rd_ptr <= rd_ptr + 1'b1;
+    end
+
+    // Drain pending writes first.  Once empty, pass a pending read through to the bus.
+    assign bus_valid_o = !empty || (spi_valid_i && spi_rw_ni);
+    assign bus_addr_o  = empty ? spi_addr_i : addr_fifo[rd_index];
+    assign bus_data_o  = empty ? spi_data_i : data_fifo[rd_index];     // (Mask of read-modify-write)
+    assign bus_rw_no   = empty && spi_rw_ni;
+    assign bus_op_o    = empty ? spi_op_i : 2'b00;
+
+    // Writes are acknowledged as soon as they are queued.  Reads are acknowledged when the
+    // bus completes the read (i.e., 'bus_done' while the FIFO is empty, which excludes the
+    // completion of the last queued write).
+    assign spi_ready_o = spi_valid_i && (spi_rw_ni
+        ? empty && bus_done
+        : !full);
+endmodule
+
+// Speculatively reads ahead of SPI reads so that sequential reads (READ_NEXT and burst reads)
+// are served without waiting for a bus slot.
+//
+// After a read at 'addr' completes on the bus, idle SPI bus slots are used to fetch 'addr + 1',
+// 'addr + 2', ... into a small buffer.  A subsequent read of the next sequential address is
+// acknowledged immediately from the buffer.  Any other read discards the buffer and restarts
+// prefetching from the new address.
+//
+// Writes that pass through to the bus, as well as external writes reported via 'wr_en_i' (e.g.,
+// the CPU), discard the buffer if they fall within the prefetched range.  Prefetching never
+// enters the I/O page ($E800-$E8FF) or the register page ($1E800-$1E8FF), where reads are not
+// side-effect free.
+module spi_read_prefetch #(
+    parameter DEPTH_LOG2 = 3            // Buffer holds 2^DEPTH_LOG2 bytes
+)(
+    input  logic clk_sys_i,
+
+    // From 'spi_write_fifo'
+    input  logic        spi_valid_i,    // SPI transaction pending: '_addr_i', '_data_i', and '_rw_ni' are valid
+    output logic        spi_ready_o = '0, // SPI transaction completed (pulse)
+    input  logic [16:0] spi_addr_i,
+    input  logic  [7:0] spi_data_i,     // Data to write
+    input  logic        spi_rw_ni,
+    input  logic  [1:0] spi_op_i,       // Read-modify-write operation (never served from the buffer)
+    output logic  [7:0] spi_data_o,     // Data from completed read
+
+    // To bus
+    output logic        bus_valid_o,    // Bus transaction pending: '_addr_o', '_data_o', and '_rw_no' are valid
+    input  logic        bus_ready_i,    // Bus transaction completed (from 'timing')
+    output logic [16:0] bus_addr_o,
+    output logic  [7:0] bus_data_o,
+    output logic        bus_rw_no,
+    output logic  [1:0] bus_op_o,
+    input  logic  [7:0] bus_data_i,     // Data read by completed bus transaction
+
+    // External writes to RAM (snooped for invalidation)
+    input  logic        wr_en_i,
+    input  logic [16:0] wr_addr_i
+);
+    localparam DEPTH = 1 << DEPTH_LOG2;
+
+    logic  [7:0] pf_data[DEPTH];
+    logic [DEPTH_LOG2-1:0] pf_rd = '0;      // Index of 'pf_head' in 'pf_data'
+    logic [DEPTH_LOG2:0]   pf_count = '0;   // Number of valid bytes in 'pf_data'
+    logic [16:0] pf_head;                   // Address of next sequential byte
+    logic [16:0] pf_bus_addr;               // Address of pending prefetch read
+    logic        pf_en = '0;                // Prefetching enabled (a read has established 'pf_head')
+    logic        pf_busy = '0;              // Prefetch read pending on bus
+    logic        pf_stale = '0;             // Pending prefetch was invalidated (discard result)
+    logic        up_busy = '0;              // SPI transaction pending on bus
+
+    // Note that 'pf_head + pf_count' (and 'pf_rd + pf_count') are unchanged by hits, so this is
+    // also where the pending prefetch is stored when it completes.
+    wire [16:0] pf_addr = pf_head + pf_count;
+    wire [DEPTH_LOG2-1:0] pf_wr = pf_rd + pf_count[DEPTH_LOG2-1:0];
+
+    // Writes in [pf_head, pf_head + DEPTH) may overlap buffered or pending bytes.
+    function automatic logic in_range(input logic [16:0] addr);
+        logic [16:0] offset;
+        offset = addr - pf_head;
+        return offset < DEPTH;
+    endfunction
+
+    // 'bus_ready_i' is asserted for one 'setup_clk' period (two 'clk_sys_i' cycles).  Only
+    // respond to its rising edge.
+    logic bus_ready_q = '0;
+    wire  bus_done = bus_ready_i && !bus_ready_q;
+
+    // 'spi_ready_o' is registered, so the SPI transaction just completed is still presented
+    // during the following cycle.
+    wire pending = spi_valid_i && !spi_ready_o && !up_busy;
+
+    // Sequential reads are served from the buffer, even while a prefetch is pending.  Other
+    // transactions wait for the bus.
+    wire hit      = pending && spi_rw_ni && spi_op_i == '0 && pf_count != '0 && spi_addr_i == pf_head;
+    wire miss     = pending && !hit && !pf_busy;
+    wire pf_issue = !up_busy && !pf_busy && !miss && pf_en
+        && pf_count != DEPTH && pf_addr[15:8] != 8'hE8;
+    wire pf_fill  = bus_done && pf_busy && !pf_stale;
+    wire snoop    = wr_en_i && in_range(wr_addr_i);
+
+    always_ff @(posedge clk_sys_i) begin
+        bus_ready_q <= bus_ready_i;
+        spi_ready_o <= '0;
+
+        if (hit) begin
+            spi_data_o  <= pf_data[pf_rd];
+            spi_ready_o <= 1'b1;
+            pf_rd       <= pf_rd + 1'b1;
+            pf_head     <= pf_head + 1'b1;
+        end
+
+        pf_count <= pf_count - hit + pf_fill;
+        if (pf_fill) pf_data[pf_wr] <= bus_data_i;
+
+        if (miss) begin
+            up_busy <= 1'b1;
+
+            // A non-sequential read restarts prefetching when it completes.  A write only
+            // discards the buffer if it overlaps.
+            if (spi_rw_ni) pf_en <= '0;
+            if (spi_rw_ni || in_range(spi_addr_i)) pf_count <= '0;
+        end
+
+        if (pf_issue) begin
+            pf_busy     <= 1'b1;
+            pf_bus_addr <= pf_addr;
+        end
+
+        if (bus_done && pf_busy) begin
+            pf_busy  <= '0;
+            pf_stale <= '0;
+        end
+
+        if (bus_done && up_busy) begin
+            up_busy     <= '0;
+            spi_ready_o <= 1'b1;
+
+            if (spi_rw_ni) begin
+                // Completed read: prefetch from the next address.
+                spi_data_o <= bus_data_i;
+                pf_head    <= spi_addr_i + 1'b1;
+                pf_rd      <= '0;
+                pf_count   <= '0;
+                pf_en      <= 1'b1;
+            end
+        end
+
+        // External writes (e.g., the CPU) take precedence over any buffer update above.
+        if (snoop) begin
+            pf_count <= '0;
+            pf_rd    <= '0;
+            pf_stale <= (pf_busy && !bus_done) || pf_issue;
+        end
+    end
+
+    assign bus_valid_o = up_busy || pf_busy;
+    assign bus_addr_o  = up_busy ? spi_addr_i : pf_bus_addr;
+    assign bus_data_o  = spi_data_i;
+    assign bus_rw_no   = up_busy ? spi_rw_ni : 1'b1;
+    assign bus_op_o    = up_busy ? spi_op_i : 2'b00;
+endmodule
+
+// Performs the read-modify-write commands from 'spi1' (AND_AT, OR_AT, XOR_AT) as a bus read
+// followed by a bus write of the modified byte.
+//
+// The read is marked atomic, so 'timing' only grants it in a slot that leaves an SPI slot for
+// the write before the CPU's next bus cycle.  The 6502 therefore never observes or modifies the
+// byte in between.  The transaction completes after the write, and returns the original byte
+// (the write does not update 'bus_data_i').  Other transactions pass through unchanged.
+module spi_rmw(
+    input  logic clk_sys_i,
+
+    // From 'spi_dma'
+    input  logic        spi_valid_i,    // SPI transaction pending: '_addr_i', '_data_i', '_rw_ni', and '_op_i' are valid
+    output logic        spi_ready_o,    // SPI transaction completed
+    input  logic [16:0] spi_addr_i,
+    input  logic  [7:0] spi_data_i,     // Data to write, or mask for read-modify-write
+    input  logic        spi_rw_ni,
+    input  logic  [1:0] spi_op_i,       // Read-modify-write operation: 0 = none, 1 = AND, 2 = OR, 3 = XOR
+
+    // To bus
+    output logic        bus_valid_o,    // Bus transaction pending: '_addr_o', '_data_o', and '_rw_no' are valid
+    input  logic        bus_ready_i,    // Bus transaction completed (from 'timing')
+    output logic [16:0] bus_addr_o,
+    output logic  [7:0] bus_data_o,
+    output logic        bus_rw_no,
+    input  logic  [7:0] bus_data_i,     // Data read by completed bus transaction
+    output logic        bus_atomic_o    // Pending read must be followed by a write before the CPU's slot
+);
+    localparam NONE = 2'd0,
+               AND  = 2'd1,
+               OR   = 2'd2,
+               XOR  = 2'd3;
+
+    logic [7:0] result;                 // Modified byte to write
+    logic       wr_phase = '0;          // Read complete, write pending
+    logic       hide     = '0;          // Suppress the remainder of the read's 'bus_ready_i'
+
+    // 'bus_ready_i' is asserted for one 'setup_clk' period (two 'clk_sys_i' cycles).  Only
+    // respond to its rising edge.
+    logic bus_ready_q = '0;
+    wire  bus_done = bus_ready_i && !bus_ready_q;
+
+    wire rmw = spi_op_i != NONE;
+
+    always_ff @(posedge clk_sys_i) begin
+        bus_ready_q <= bus_ready_i;
+
+        if (bus_done) begin
+            if (rmw && !wr_phase) begin
+                wr_phase <= 1'b1;
+                hide     <= 1'b1;
+
+                unique case (spi_op_i)
+                    AND:     result <= bus_data_i & spi_data_i;
+                    OR:      result <= bus_data_i | spi_data_i;
+                    default: result <= bus_data_i ^ spi_data_i;
+                endcase
+            end else begin
+                wr_phase <= '0;
+            end
+        end else if (!bus_ready_i) begin
+            hide <= '0;
+        end
+    end
+
+    assign bus_valid_o  = spi_valid_i;
+    assign bus_addr_o   = spi_addr_i;
+    assign bus_data_o   = wr_phase ? result : spi_data_i;
+    assign bus_rw_no    = rmw ? !wr_phase : spi_rw_ni;
+    assign bus_atomic_o = rmw && !wr_phase;
+    assign spi_ready_o  = bus_ready_i && !hide && (!rmw || wr_phase);
+endmodule
@@ -0,0 +1,70 @@
+/**
+ * PET Clone - Open hardware implementation of the Commodore PET
+ * by Daniel Lehenbauer and contributors.
+ * 
+ * https://github.com/DLehenbauer/commodore-pet-clone
+ *
+ * To the extent possible under law, I, Daniel Lehenbauer, have waived all
+ * copyright and related or neighboring rights to this project. This work is
+ * published from the United States.
+ *
+ * @copyright CC0 http://creativecommons.org/publicdomain/zero/1.0/
+ * @author Daniel Lehenbauer <DLehenbauer@users.noreply.github.com> and contributors
+ */
+
+// Registers in the SPI-only page at $1E800-$1E8FF.  (The CPU does not drive A16, so this page
+// is not visible to the 6502.)
+//
+//   $1E800-$1E80F  VRAM_DIRTY  Dirty bitmap for display RAM and the character generator in RAM.
+//                              Bit 'n % 8' of byte 'n / 8' is set when the 32 bytes at
+//                              $8000 + 32n are written by the CPU or SPI.  (Bytes 0-7 cover
+//                              display RAM at $8000-$87FF, bytes 8-15 cover the character
+//                              generator at $8800-$8FFF.)  Reading a byte returns it and clears
+//                              it in the same bus cycle, so no write is lost between reading and
+//                              clearing.  All bits are set at power on.
+//
+//   $1E820-$1E83F  CRTC        CRTC registers R0..R31 (read only).  Allows the MCU to mirror the
+//                              display layout (columns, rows, scan lines and start address).
+//
+//   $1E850-$1E85F  DMA         Fill/copy/compare/CRC/March test engine registers (see
+//                              'spi_dma').
+module spi_regs(
+    input  logic        strobe_clk_i,   // Bus clock
+
+    input  logic  [7:0] addr_i,         // Register offset within page
+    input  logic        rd_en_i,        // SPI read from page
+    input  logic        wr_en_i,        // SPI write to page
+    output logic  [7:0] data_o,         // Register data (valid while 'rd_en_i')
+
+    input  logic        vram_wr_en_i,   // Write to RAM at $8000-$8FFF (CPU or SPI)
+    input  logic [11:0] vram_addr_i,    // RAM address of write (after mirroring)
+
+    input  logic  [7:0] crtc_r_i,       // Value of CRTC register 'addr_i[4:0]'
+
+    output logic        dma_wr_en_o,    // SPI write to DMA engine register 'addr_i[3:0]'
+    input  logic  [7:0] dma_data_i      // Value of DMA engine register 'addr_i[3:0]'
+);
+    localparam VRAM_DIRTY  = 8'h00,
+               CRTC        = 8'h20,
+               DMA         = 8'h50;
+
+    logic [127:0] vram_dirty = '1;
+
+    wire rd_dirty = rd_en_i && addr_i[7:4] == VRAM_DIRTY[7:4];
+    wire rd_crtc  = rd_en_i && addr_i[7:5] == CRTC[7:5];
+    wire rd_dma   = rd_en_i && addr_i[7:4] == DMA[7:4];
+
+    assign dma_wr_en_o = wr_en_i && addr_i[7:4] == DMA[7:4];
+
+    always_ff @(negedge strobe_clk_i) begin
+        if (rd_dirty) vram_dirty[addr_i[3:0]*8 +: 8] <= '0;
+        if (vram_wr_en_i) vram_dirty[vram_addr_i[11:5]] <= 1'b1;
+    end
+
+    always_comb begin
+        if (rd_dirty) data_o = vram_dirty[addr_i[3:0]*8 +: 8];
+        else if (rd_crtc) data_o = crtc_r_i;
+        else if (rd_dma) data_o = dma_data_i;
+        else data_o = '0;
+    end
+endmodule
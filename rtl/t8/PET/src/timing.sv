@@ -19,7 +19,12 @@ module timing(
     output logic cpu_clk_o,
     output logic cpu_be_o       = '0,
     output logic cpu_en_o       = '0,
+    output logic cclk_en_o      = '0,   // 1 MHz clock enable (continues while the CPU is halted)
+    input  logic cpu_halt_i,        // CPU is halted (RDY low) and the DMA engine may use its slots 6 and 7
     input  logic spi_valid_i,
+    input  logic spi_atomic_i,      // Pending SPI read must be followed by a write before the CPU's slot
+    input  logic video_blank_i,     // Current character is not displayed (video fetches unused)
+    input  logic video_80_col_i,    // 80 column mode (uses 'vram1' and 'vrom1' slots)
     output logic spi_en_o       = '0,
     output logic spi_ready_o    = 1'b1,
     output logic vram0_en_o     = '0,
@@ -79,17 +84,57 @@ module timing(
         en_d = { en_q[6:0], en_q[7] };
     end
     
+    // SPI transactions always use slot 0 and the otherwise idle slot 5.  In addition, video slots
+    // are given to a pending SPI transaction when the video fetch is unused:
+    //
+    //   - 'vrom0' while the current character is blanked (border, retrace, or scanlines below the
+    //     character ROM).  'vram0' is not reallocated because 'de' may still change at the start
+    //     of slot 1.
+    //   - 'vram1' and 'vrom1' while blanked or in 40 column mode.
+    //
+    // While 'cpu_halt_i' is asserted (the MCU holds the CPU with RDY low while the DMA engine is
+    // busy, e.g., during the March test), the CPU's slots 6 and 7 are also given to SPI.  'BE' is
+    // deasserted so the CPU releases the bus, and 'cpu_en' is suppressed so no CPU access is
+    // decoded.  Other halts leave the CPU's slots unchanged.  'cpu_halt_i' is sampled in slot 5,
+    // so that slots 6 and 7 of the same cycle are always allocated together.
+    //
+    // SPI is never granted consecutive slots, which gives the requester a slot to present the
+    // next transaction after 'spi_ready' is asserted.
+    logic cpu_halt = '0;            // 'cpu_halt_i' sampled in slot 5
+
+    wire vrom0_free = video_blank_i;
+    wire vid1_free  = video_blank_i || !video_80_col_i;
+
+    wire spi_slot = en_d[0] || en_d[5]
+        || (en_d[2] && vrom0_free)
+        || ((en_d[3] || en_d[4]) && vid1_free)
+        || ((en_d[6] || en_d[7]) && cpu_halt);
+
+    // An atomic read (the read of a read-modify-write, see 'spi_rmw') is only granted in slots 0,
+    // 2 and 3, so that its write is guaranteed a slot before the CPU's slots 6 and 7 (at the
+    // latest, slot 5).
+    wire spi_atomic_slot = en_d[0]
+        || (en_d[2] && vrom0_free)
+        || (en_d[3] && vid1_free);
+
+    wire spi_grant = spi_valid_i && (spi_atomic_i ? spi_atomic_slot : spi_slot) && !spi_en_o;
+
+    always_ff @(posedge setup_clk_o) begin
+        if (en_d[5]) cpu_halt <= cpu_halt_i;
+    end
+
     always_ff @(posedge setup_clk_o) begin
-        spi_en_o     <= spi_valid_i && en_d[0];
+        spi_en_o     <= spi_grant;
         spi_ready_o  <= spi_en_o;
 
         vram0_en_o    <= en_d[1];
-        vrom0_en_o    <= en_d[2];
-        vram1_en_o    <= en_d[3];
-        vrom1_en_o    <= en_d[4];
+        vrom0_en_o    <= en_d[2] && !spi_grant;
+        vram1_en_o    <= en_d[3] && !spi_grant;
+        vrom1_en_o    <= en_d[4] && !spi_grant;
         
-        cpu_be_o     <= en_d[6] || en_d[7];
-        cpu_en_o     <= en_d[7];
+        cpu_be_o     <= (en_d[6] || en_d[7]) && !cpu_halt;
+        cpu_en_o     <= en_d[7] && !cpu_halt;
+        cclk_en_o    <= en_d[7];
 
         en_q         <= en_d;
     end
@@ -100,9 +145,12 @@ module timing(
     //               : . : . : . : . : . : . : . : . : . : . : . : . : . : . : . : . : . 
     // strobe_clk   _/‾‾‾\___/‾‾‾\___/‾‾‾\___/‾‾‾\___/‾‾‾\___/‾‾‾\___/‾‾‾\___/‾‾‾\___/‾‾
     //               : . : . : . : . : . : . : . : . : . : . : . : . : . : . : . : . : . 
-    //     cpu_en   _______________________________________________________/‾‾‾‾‾‾‾\____
+    //    cclk_en   _______________________________________________________/‾‾‾‾‾‾‾\____
     //               : . : . : . : . : . : . : . : . : . : . : . : . : . : . : . : . : . 
     //    cpu_clk   _________________________________________________________/‾‾‾\______
+    //
+    // The clock keeps running while the CPU is halted, so the halted 65C02 (and the VIA and PIA
+    // timers clocked by PHI2) see an uninterrupted 1 MHz clock.
 
-    assign cpu_clk_o = strobe_clk_o & cpu_en_o;
+    assign cpu_clk_o = strobe_clk_o & cclk_en_o;
 endmodule
@@ -35,7 +35,13 @@ module video(
 
     output logic        h_sync_o,
     output logic        v_sync_o,
-    output logic        video_o
+    output logic        video_o,
+
+    output logic        blank_o,            // Current character is not displayed
+    input  logic        col_80_mode_i,      // 80 column mode (2 characters per CRTC address)
+
+    input  logic  [4:0] crtc_spi_ar_i,      // CRTC register read by MCU via SPI
+    output logic  [7:0] crtc_spi_r_o        // Value of CRTC register 'crtc_spi_ar_i'
 );
     logic [13:0] ma;
     logic [4:0] ra;
@@ -58,14 +64,14 @@ module video(
         .v_sync_o(vs),
         .de_o(de),
         .ma_o(ma),
-        .ra_o(ra)
+        .ra_o(ra),
+        .spi_ar_i(crtc_spi_ar_i),
+        .spi_r_o(crtc_spi_r_o)
     );
 
-    logic col_80_mode = '0;
-
     always_comb begin
         if (vram0_en_i) begin
-            if (col_80_mode) addr_o = { 3'b000, ma[9:0], 1'b0 };
+            if (col_80_mode_i) addr_o = { 3'b000, ma[9:0], 1'b0 };
             else addr_o = { 4'b0000, ma[9:0] };
         end
         else if (vrom0_en_i) addr_o = { 2'b1, gfx_i, even_char[6:0], ra[2:0] };
@@ -105,7 +111,7 @@ module video(
 
     dotgen dotgen(
         .clk_i(clk16_i),
-        .pixel_clk_en(col_80_mode ? 1'b1 : strobe_clk_i),
+        .pixel_clk_en(col_80_mode_i ? 1'b1 : strobe_clk_i),
         .video_latch(video_strobe),
         .pixels_i(next_pixels),
         .display_en_i(de && !no_row),
@@ -113,6 +119,8 @@ module video(
         .video_o(video_o)
     );
 
+    assign blank_o = !(de && !no_row);
+
     assign h_sync_o = !hs;
     assign v_sync_o = !vs;
 endmodule
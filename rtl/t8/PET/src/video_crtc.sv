@@ -32,7 +32,10 @@ module crtc(
     output logic        de_o,                   // Display enable
 
     output logic [13:0] ma_o,                   // Refresh RAM address lines
-    output logic  [4:0] ra_o                    // Raster address lines
+    output logic  [4:0] ra_o,                   // Raster address lines
+
+    input  logic  [4:0] spi_ar_i,               // Register read by MCU via SPI (see 'spi_regs')
+    output logic  [7:0] spi_r_o                 // Value of register 'spi_ar_i'
 );
     localparam R0_H_TOTAL           = 0,    // [7:0] Total displayed and non-displayed characters, minus one, per horizontal line.
                                             //       The frequency of HSYNC is thus determined by this register.
@@ -81,6 +84,9 @@ module crtc(
         ? { 2'b0, v_sync, 5'b0 }                // RS = 0: Read status register
         : r[ar];                                // RS = 1: Read addressed register R0..17 (TODO: Allow this?  Infers dual-port RAM?)
 
+    // Second read port allows the MCU to mirror the display layout (e.g., for DVI output).
+    assign spi_r_o = r[spi_ar_i];
+
     initial begin
         r[R0_H_TOTAL]           = 8'd63;
         r[R1_H_DISPLAYED]       = 8'd40;
@@ -26,6 +26,13 @@ set BINDIR=C:\Efinity\2022.2\bin
     :: iverilog from the root of the project directory.
     pushd %PROJDIR%
 
+    :: Run the SPI link testbench first, since the rest of the simulation depends on the link.
+    iverilog.exe -g2009 -s spi_tb -o%PROJDIR%\work_sim\spi.vvp -f%PROJDIR%\work_sim\PET.f
+    if %ERRORLEVEL% neq 0 popd && exit /b %ERRORLEVEL%
+
+    vvp.exe -l%PROJDIR%\outflow\spi.rtl.simlog %PROJDIR%\work_sim\spi.vvp
+    if %ERRORLEVEL% neq 0 popd && exit /b %ERRORLEVEL%
+
     iverilog.exe -g2009 -s sim -o%PROJDIR%\work_sim\PET.vvp -f%PROJDIR%\work_sim\PET.f
     ::iverilog.exe -g2009 -s address_decoding_tb -o%PROJDIR%\work_sim\PET.vvp -f%PROJDIR%\work_sim\PET.f
     if %ERRORLEVEL% neq 0 popd && exit /b %ERRORLEVEL%